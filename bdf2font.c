@@ -0,0 +1,383 @@
+/************************************************************************
+ *  @file bdf2font.c
+ *
+ *  @brief
+ *
+ *   Font converter for the ST7565 Graphic LCD driver
+ *  ------------------------------------------------------------
+ *
+ *  Converts bitmap fonts in the BDF format (Glyph Bitmap Distribution
+ *  Format, as used by X11 and made by most bitmap font editors) into the
+ *  C font tables of lcdST7565.c. Outline fonts (TTF / OTF) can be turned
+ *  into BDF at a given pixel size first with 'otf2bdf'.
+ *
+ *  Usage: ./bdf2font [-r first-last] font.bdf ... > lcdFonts.h
+ *         ./bdf2font [-r first-last] -o font.lcdf font.bdf
+ *
+ *  The second form writes a font file for 'lcd fontfile', for large
+ *  fonts (Eg. GNU Unifont) which are only read as the glyphs are used.
+ *
+ *  - Every BDF file gives one font, named after the file.
+ *  - The glyph cell is the BDF font height (ascent + descent) and the
+ *    glyph advance (DWIDTH) wide, so glyphs get their own width and the
+ *    spacing of the font design.
+ *  - Glyphs are stored in the page layout of the LCD: for each page of
+ *    8 pixel lines from the top, one byte per column with the top pixel
+ *    in the MSB. Only the columns of each glyph are kept.
+ *  - The characters first - last (Default 32 - 126, all for a font
+ *    file) are taken by their Unicode code point (BDF ENCODING), ones
+ *    missing in the font get no glyph.
+ *
+ *  Font file - all numbers little endian:
+ *    Header (16 bytes):
+ *      "L7F1"       Magic
+ *      uint32_t     Glyph count
+ *      uint8_t      Pages (height)
+ *      uint8_t      Nominal width
+ *      uint8_t      reserved[6]
+ *    Index, a record of 8 bytes for each glyph in code point order:
+ *      uint32_t     Code point (bits 0 - 23) and width (bits 24 - 31)
+ *      uint32_t     File offset of the glyph, pages x width bytes
+ *
+ *  @note
+ *  Author: boseji <prog.ic@live.in>
+ *
+ *  @license
+ *  License:
+ *  This work is licensed under a Creative Commons
+ *  Attribution-ShareAlike 4.0 International License.
+ *  http://creativecommons.org/licenses/by-sa/4.0/
+ *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/* Limits of the LCD driver - lcdST7565.c */
+#define BDF2FONT_MAX_PAGES   4   /* ST7565_LCD_FONT_MAXPAGES */
+#define BDF2FONT_MAX_WIDTH   32  /* Glyph advance */
+#define BDF2FONT_MAX_CODE    0x10FFFF
+#define BDF2FONT_MAGIC       "L7F1"
+
+typedef struct
+{
+  long    code;
+  uint8_t width;
+  uint8_t data[BDF2FONT_MAX_PAGES][BDF2FONT_MAX_WIDTH];
+} bdf_glyph_t;
+
+/* Glyphs of the font being converted - in code point order after
+   _bdf_read */
+static bdf_glyph_t *gp_glyphs = NULL;
+static size_t gn_glyphs = 0;
+
+/**
+ *  Function to make a C name out of the file name - "fonts/6x13B.bdf"
+ *  gives "6x13B"
+ */
+static void _bdf_name ( const char *sPath, char *sName, size_t size )
+{
+  const char *p = strrchr(sPath, '/');
+  size_t n = 0;
+  p = (p != NULL) ? p + 1 : sPath;
+  for (; *p != 0 && *p != '.' && n + 1 < size; p++)
+  {
+    sName[n++] = isalnum((unsigned char)*p) ? *p : '_';
+  }
+  sName[n] = 0;
+}
+
+/**
+ *  Function to order the glyphs by code point
+ */
+static int _bdf_cmp ( const void *pA, const void *pB )
+{
+  const bdf_glyph_t *a = pA, *b = pB;
+  return (a->code > b->code) - (a->code < b->code);
+}
+/**
+ *  Function to find the glyph of a code point, NULL if there is none
+ */
+static const bdf_glyph_t *_bdf_find ( long code )
+{
+  bdf_glyph_t key;
+  key.code = code;
+  return bsearch(&key, gp_glyphs, gn_glyphs, sizeof(key), _bdf_cmp);
+}
+/**
+ *  Function to read one BDF font into gp_glyphs
+ *
+ *  @return Number of pages of the font, -1 on error
+ */
+static int _bdf_read ( const char *sPath, long first, long last )
+{
+  size_t size = 0;
+  char line[512];
+  FILE *f;
+  int ascent = -1, descent = -1, fbh = 0, fby = 0;
+  long enc = -1;
+  int dwidth = 0, bw = 0, bh = 0, bx = 0, by = 0;
+  int height, pages, row = -1, x, y;
+  bdf_glyph_t *pGlyph = NULL;
+
+  f = fopen(sPath, "r");
+  if (f == NULL)
+  {
+    fprintf(stderr, "bdf2font: can not open %s\n", sPath);
+    return -1;
+  }
+  gn_glyphs = 0;
+  height = pages = 0;
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    if (row >= 0)
+    {
+      /* Bitmap rows - hex, MSB is the left pixel */
+      unsigned long bits;
+      int nbits;
+      if (strncmp(line, "ENDCHAR", 7) == 0)
+      {
+        row = -1;
+        continue;
+      }
+      nbits = (int)(strspn(line, "0123456789abcdefABCDEF") * 4);
+      bits = strtoul(line, NULL, 16);
+      y = ascent - by - bh + row++;
+      if (pGlyph == NULL || y < 0 || y >= height) continue;
+      for (x = 0; x < bw && x < nbits; x++)
+      {
+        int col = bx + x;
+        if (col < 0 || col >= pGlyph->width) continue;
+        if ((bits >> (nbits - 1 - x)) & 1)
+        {
+          pGlyph->data[y >> 3][col] |= (uint8_t)(0x80 >> (y & 7));
+        }
+      }
+      continue;
+    }
+    if (sscanf(line, "FONTBOUNDINGBOX %*d %d %*d %d", &fbh, &fby) == 2)
+      continue;
+    if (sscanf(line, "FONT_ASCENT %d", &ascent) == 1) continue;
+    if (sscanf(line, "FONT_DESCENT %d", &descent) == 1) continue;
+    if (sscanf(line, "ENCODING %ld", &enc) == 1) continue;
+    if (sscanf(line, "DWIDTH %d", &dwidth) == 1) continue;
+    if (sscanf(line, "BBX %d %d %d %d", &bw, &bh, &bx, &by) == 4) continue;
+    if (strncmp(line, "CHARS ", 6) == 0)
+    {
+      /* Glyphs start - the font height is known by now */
+      if (ascent < 0) ascent = fbh + fby;
+      if (descent < 0) descent = -fby;
+      height = ascent + descent;
+      pages = (height + 7) / 8;
+      if (height <= 0 || pages > BDF2FONT_MAX_PAGES)
+      {
+        fprintf(stderr, "bdf2font: %s is %d pixels high, %d is the most\n",
+          sPath, height, BDF2FONT_MAX_PAGES * 8);
+        fclose(f);
+        return -1;
+      }
+      continue;
+    }
+    if (strncmp(line, "STARTCHAR", 9) == 0)
+    {
+      enc = -1;
+      dwidth = bw = bh = bx = by = 0;
+      continue;
+    }
+    if (strncmp(line, "BITMAP", 6) == 0)
+    {
+      row = 0;
+      pGlyph = NULL;
+      if (enc < first || enc > last || height == 0) continue;
+      if (dwidth > BDF2FONT_MAX_WIDTH) dwidth = BDF2FONT_MAX_WIDTH;
+      if (dwidth <= 0) continue;
+      if (gn_glyphs == size)
+      {
+        size = size ? size * 2 : 256;
+        gp_glyphs = realloc(gp_glyphs, size * sizeof(*gp_glyphs));
+        if (gp_glyphs == NULL)
+        {
+          fprintf(stderr, "bdf2font: out of memory\n");
+          exit(1);
+        }
+      }
+      pGlyph = &gp_glyphs[gn_glyphs++];
+      memset(pGlyph, 0, sizeof(*pGlyph));
+      pGlyph->code = enc;
+      pGlyph->width = (uint8_t)dwidth;
+    }
+  }
+  fclose(f);
+  if (pages == 0)
+  {
+    fprintf(stderr, "bdf2font: %s is not a BDF font\n", sPath);
+    return -1;
+  }
+  qsort(gp_glyphs, gn_glyphs, sizeof(*gp_glyphs), _bdf_cmp);
+  return pages;
+}
+
+/**
+ *  Function to print the C tables of the font read by @ref _bdf_read
+ */
+static void _bdf_print ( const char *sName, const char *sPath, int pages,
+  int first, int last )
+{
+  const bdf_glyph_t *g[256];
+  unsigned long offset = 0, n = 0;
+  int c, p, x, widest = 0;
+
+  /* Glyphs by character - NULL if the font has none */
+  for (c = first; c <= last; c++) g[c] = _bdf_find(c);
+
+  printf("/* %s - from %s */\n", sName, sPath);
+  printf("static const uint8_t gca_font_%s_bitmap[] =\n{", sName);
+  for (c = first; c <= last; c++)
+  {
+    for (p = 0; p < pages && g[c] != NULL; p++)
+    {
+      for (x = 0; x < g[c]->width; x++)
+      {
+        printf("%s0x%02X,", (n++ % 12) ? " " : "\n  ", g[c]->data[p][x]);
+      }
+    }
+  }
+  printf("\n};\n");
+  printf("static const lcd_glyph_t gca_font_%s_glyphs[] =\n{\n", sName);
+  for (c = first; c <= last; c++)
+  {
+    unsigned width = (g[c] != NULL) ? g[c]->width : 0;
+    printf("  {%u, %lu}, /* %d */\n", width, width ? offset : 0, c);
+    offset += (unsigned long)width * pages;
+    if ((int)width > widest) widest = (int)width;
+  }
+  printf("};\n");
+  /* Nominal width - the digits, for the cursor and backspace */
+  if (first <= '0' && last >= '0' && g['0'] != NULL) widest = g['0']->width;
+  printf("static const lcd_font_t gs_font_%s =\n{\n", sName);
+  printf("  \"%s\", %d, %d, %d, %d,\n", sName, first, last, pages, widest);
+  printf("  gca_font_%s_glyphs, gca_font_%s_bitmap, NULL\n};\n\n", sName,
+    sName);
+}
+
+static void _bdf_put ( uint8_t *p, unsigned long v )
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+/**
+ *  Function to write the font read by @ref _bdf_read as a font file
+ */
+static int _bdf_write ( const char *sPath, int pages )
+{
+  uint8_t header[16], rec[8];
+  const bdf_glyph_t *pZero = _bdf_find('0');
+  unsigned long offset;
+  size_t i;
+  int p, widest = 0;
+  FILE *f = fopen(sPath, "wb");
+
+  if (f == NULL)
+  {
+    fprintf(stderr, "bdf2font: can not create %s\n", sPath);
+    return -1;
+  }
+  for (i = 0; i < gn_glyphs; i++)
+    if (gp_glyphs[i].width > widest) widest = gp_glyphs[i].width;
+  memset(header, 0, sizeof(header));
+  memcpy(header, BDF2FONT_MAGIC, 4);
+  _bdf_put(&header[4], (unsigned long)gn_glyphs);
+  header[8] = (uint8_t)pages;
+  header[9] = (uint8_t)((pZero != NULL) ? pZero->width : widest);
+  fwrite(header, 1, sizeof(header), f);
+  offset = sizeof(header) + 8UL * gn_glyphs;
+  for (i = 0; i < gn_glyphs; i++)
+  {
+    _bdf_put(&rec[0], (unsigned long)gp_glyphs[i].code |
+      ((unsigned long)gp_glyphs[i].width << 24));
+    _bdf_put(&rec[4], offset);
+    fwrite(rec, 1, sizeof(rec), f);
+    offset += (unsigned long)gp_glyphs[i].width * pages;
+  }
+  for (i = 0; i < gn_glyphs; i++)
+  {
+    for (p = 0; p < pages; p++)
+      fwrite(gp_glyphs[i].data[p], 1, gp_glyphs[i].width, f);
+  }
+  if (fclose(f) != 0)
+  {
+    fprintf(stderr, "bdf2font: can not write %s\n", sPath);
+    return -1;
+  }
+  fprintf(stderr, "%s: %lu glyphs, %d pages, %lu bytes\n", sPath,
+    (unsigned long)gn_glyphs, pages, offset);
+  return 0;
+}
+
+int main ( int argc, char **argv )
+{
+  char sName[64];
+  const char *sOut = NULL;
+  long first = -1, last = -1;
+  int i, pages;
+
+  /* Font file - one BDF font with all its characters by default */
+  for (i = 1; i + 1 < argc; i++)
+  {
+    if (strcmp(argv[i], "-o") == 0) sOut = argv[i + 1];
+  }
+
+  if (sOut == NULL)
+    printf("/* Fonts for lcdST7565.c - Generated by bdf2font, do not edit */\n\n");
+  for (i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+    {
+      /* Decimal or 0x hex */
+      char *pEnd;
+      first = strtol(argv[++i], &pEnd, 0);
+      last = (*pEnd == '-') ? strtol(pEnd + 1, &pEnd, 0) : -1;
+      if (*pEnd != 0 || first < 0 || first > last ||
+        last > (sOut ? BDF2FONT_MAX_CODE : 255))
+      {
+        fprintf(stderr, "bdf2font: bad range %s\n", argv[i]);
+        return 1;
+      }
+      continue;
+    }
+    if (strcmp(argv[i], "-o") == 0)
+    {
+      i++;
+      continue;
+    }
+    if (first < 0)
+    {
+      first = sOut ? 0 : 32;
+      last = sOut ? BDF2FONT_MAX_CODE : 126;
+    }
+    pages = _bdf_read(argv[i], first, last);
+    if (pages < 0) return 1;
+    if (sOut != NULL) return (_bdf_write(sOut, pages) == 0) ? 0 : 1;
+    _bdf_name(argv[i], sName, sizeof(sName));
+    _bdf_print(sName, argv[i], pages, (int)first, (int)last);
+  }
+  /* Font table entries in the order given */
+  printf("#define ST7565_LCD_FONTS_GENERATED");
+  for (i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "-o") == 0)
+    {
+      i++;
+      continue;
+    }
+    _bdf_name(argv[i], sName, sizeof(sName));
+    printf(" \\\n  &gs_font_%s,", sName);
+  }
+  printf("\n");
+  return 0;
+}
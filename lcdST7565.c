@@ -44,12 +44,35 @@
 /************************************************************************/
 
 #include <stdio.h>
+#include <stdarg.h>
+#if !defined(ST7565_USE_SPIDEV) && !defined(ST7565_USE_SIM)
 #include <pigpio.h>
+#endif
 #include <stdint.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
 #include <fcntl.h>
+#include <dirent.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <time.h>
+#ifdef ST7565_USE_SPIDEV
+#include <linux/gpio.h>
+#include <linux/spi/spidev.h>
+#endif
 
 /************************************************************************/
 /* Rpi-ST7565 LCD Connection with 40pin RpiB+ or 26pin RpiB             */
@@ -67,7 +90,12 @@
     GPIO11(SPI_CLK)  - SCLK
     GPIO24           - A0
     GPIO25           - nRST
-    GPIO08(SPI_CE0N) - nCS   */
+    GPIO08(SPI_CE0N) - nCS
+
+    A second LCD (Display 1) shares SID, SCLK and the supplies
+    GPIO23           - A0
+    GPIO22           - nRST
+    GPIO07(SPI_CE1N) - nCS   */
     
 /************************************************************************/
 
@@ -75,19 +103,15 @@
 /* Global Variables                                                     */
 /************************************************************************/
 
-/* Global SPI bus handle */
-static int gx_spihandle = -1;
-
-/* Global position storage for the Cursor */
-static uint16_t gw_row = 0;
-static uint16_t gw_column = 0;
+/* The Cursor, the controller state and the buffers are kept per
+   Display, see the Display Context section */
 
 /* Adafruit White LED ST7565 LCD 
    128 x 64 pixels
    http://www.adafruit.com/products/250
-   - This needs to be enabled if using the Adafruit version
-    of the LCD. The problem is with the weird page memory locations.
-    Also the Number of columns is one on excess of 128.
+   - This makes the 'adafruit' Panel Profile the Default, it can also
+    be picked at run time. The problem is with the weird page memory
+    locations. Also the Number of columns is one on excess of 128.
    
    - Comment this out when using the Normal LCD version which does 
    not have the changeover in the page memory and the additional line.
@@ -107,12 +131,18 @@ static uint16_t gw_column = 0;
 #define LCD_nRST    25
 #define LCD_nCS     8
 
+/* Display 1 on the second chip select */
+#define LCD1_A0     23
+#define LCD1_nRST   22
+#define LCD1_nCS    7
+
 /************************************************************************/
 /* Commands                                                             */
 /************************************************************************/
 
 #define BLACK 1
 #define WHITE 0
+#define INVERT 2
 
 #define ST7565_LCD_CMD_DISPLAY_OFF           0xAE
 #define ST7565_LCD_CMD_DISPLAY_ON            0xAF
@@ -153,278 +183,6 @@ static uint16_t gw_column = 0;
 #define ST7565_LCD_CMD_NOP                   0xE3
 #define ST7565_LCD_CMD_TEST                  0xF0
 
-/************************************************************************/
-/* Font Definitions                                                     */
-/************************************************************************/
-/**
- * 5x7 LCD font 'flipped' for the ST7565 - public domain
- * @note This is a 256 character font. Delete glyphs in order to save Flash
- */
-/* Controls the definition of the Font array and character spcing */
-//#define FULL_FONT
-static const uint8_t gca_font[] =
-{
-#ifdef FULL_FONT
-  0x0, 0x0, 0x0, 0x0, 0x0,          /* ASC(00) */
-  0x7C, 0xDA, 0xF2, 0xDA, 0x7C,     /* ASC(01) */
-  0x7C, 0xD6, 0xF2, 0xD6, 0x7C,     /* ASC(02) */
-  0x38, 0x7C, 0x3E, 0x7C, 0x38,   /* ASC(03) */
-  0x18, 0x3C, 0x7E, 0x3C, 0x18,   /* ASC(04) */
-  0x38, 0xEA, 0xBE, 0xEA, 0x38,   /* ASC(05) */
-  0x38, 0x7A, 0xFE, 0x7A, 0x38,   /* ASC(06) */
-  0x0, 0x18, 0x3C, 0x18, 0x0,   /* ASC(07) */
-  0xFF, 0xE7, 0xC3, 0xE7, 0xFF,   /* ASC(08) */
-  0x0, 0x18, 0x24, 0x18, 0x0,   /* ASC(09) */
-  0xFF, 0xE7, 0xDB, 0xE7, 0xFF,   /* ASC(10) */
-  0xC, 0x12, 0x5C, 0x60, 0x70,   /* ASC(11) */
-  0x64, 0x94, 0x9E, 0x94, 0x64,   /* ASC(12) */
-  0x2, 0xFE, 0xA0, 0xA0, 0xE0,   /* ASC(13) */
-  0x2, 0xFE, 0xA0, 0xA4, 0xFC,   /* ASC(14) */
-  0x5A, 0x3C, 0xE7, 0x3C, 0x5A,   /* ASC(15) */
-  0xFE, 0x7C, 0x38, 0x38, 0x10,   /* ASC(16) */
-  0x10, 0x38, 0x38, 0x7C, 0xFE,   /* ASC(17) */
-  0x28, 0x44, 0xFE, 0x44, 0x28,   /* ASC(18) */
-  0xFA, 0xFA, 0x0, 0xFA, 0xFA,   /* ASC(19) */
-  0x60, 0x90, 0xFE, 0x80, 0xFE,   /* ASC(20) */
-  0x0, 0x66, 0x91, 0xA9, 0x56,   /* ASC(21) */
-  0x6, 0x6, 0x6, 0x6, 0x6,   /* ASC(22) */
-  0x29, 0x45, 0xFF, 0x45, 0x29,   /* ASC(23) */
-  0x10, 0x20, 0x7E, 0x20, 0x10,   /* ASC(24) */
-  0x8, 0x4, 0x7E, 0x4, 0x8,   /* ASC(25) */
-  0x10, 0x10, 0x54, 0x38, 0x10,   /* ASC(26) */
-  0x10, 0x38, 0x54, 0x10, 0x10,   /* ASC(27) */
-  0x78, 0x8, 0x8, 0x8, 0x8,   /* ASC(28) */
-  0x30, 0x78, 0x30, 0x78, 0x30,   /* ASC(29) */
-  0xC, 0x1C, 0x7C, 0x1C, 0xC,   /* ASC(30) */
-  0x60, 0x70, 0x7C, 0x70, 0x60,   /* ASC(31) */
-#endif
-    0x0, 0x0, 0x0, 0x0, 0x0, /* ASC(32) */
-    0x0, 0x0, 0xFA, 0x0, 0x0, /* ASC(33) */
-    0x0, 0xE0, 0x0, 0xE0, 0x0, /* ASC(34) */
-    0x28, 0xFE, 0x28, 0xFE, 0x28, /* ASC(35) */
-    0x24, 0x54, 0xFE, 0x54, 0x48, /* ASC(36) */
-    0xC4, 0xC8, 0x10, 0x26, 0x46, /* ASC(37) */
-    0x6C, 0x92, 0x6A, 0x4, 0xA, /* ASC(38) */
-    0x0, 0x10, 0xE0, 0xC0, 0x0, /* ASC(39) */
-    0x0, 0x38, 0x44, 0x82, 0x0, /* ASC(40) */
-    0x0, 0x82, 0x44, 0x38, 0x0, /* ASC(41) */
-    0x54, 0x38, 0xFE, 0x38, 0x54, /* ASC(42) */
-    0x10, 0x10, 0x7C, 0x10, 0x10, /* ASC(43) */
-    0x0, 0x1, 0xE, 0xC, 0x0, /* ASC(44) */
-    0x10, 0x10, 0x10, 0x10, 0x10, /* ASC(45) */
-    0x0, 0x0, 0x6, 0x6, 0x0, /* ASC(46) */
-    0x4, 0x8, 0x10, 0x20, 0x40, /* ASC(47) */
-    0x7C, 0x8A, 0x92, 0xA2, 0x7C, /* ASC(48) */
-    0x0, 0x42, 0xFE, 0x2, 0x0, /* ASC(49) */
-    0x4E, 0x92, 0x92, 0x92, 0x62, /* ASC(50) */
-    0x84, 0x82, 0x92, 0xB2, 0xCC, /* ASC(51) */
-    0x18, 0x28, 0x48, 0xFE, 0x8, /* ASC(52) */
-    0xE4, 0xA2, 0xA2, 0xA2, 0x9C, /* ASC(53) */
-    0x3C, 0x52, 0x92, 0x92, 0x8C, /* ASC(54) */
-    0x82, 0x84, 0x88, 0x90, 0xE0, /* ASC(55) */
-    0x6C, 0x92, 0x92, 0x92, 0x6C, /* ASC(56) */
-    0x62, 0x92, 0x92, 0x94, 0x78, /* ASC(57) */
-    0x0, 0x0, 0x28, 0x0, 0x0, /* ASC(58) */
-    0x0, 0x2, 0x2C, 0x0, 0x0, /* ASC(59) */
-    0x0, 0x10, 0x28, 0x44, 0x82, /* ASC(60) */
-    0x28, 0x28, 0x28, 0x28, 0x28, /* ASC(61) */
-    0x0, 0x82, 0x44, 0x28, 0x10, /* ASC(62) */
-    0x40, 0x80, 0x9A, 0x90, 0x60, /* ASC(63) */
-    0x7C, 0x82, 0xBA, 0x9A, 0x72, /* ASC(64) */
-    0x3E, 0x48, 0x88, 0x48, 0x3E, /* ASC(65) */
-    0xFE, 0x92, 0x92, 0x92, 0x6C, /* ASC(66) */
-    0x7C, 0x82, 0x82, 0x82, 0x44, /* ASC(67) */
-    0xFE, 0x82, 0x82, 0x82, 0x7C, /* ASC(68) */
-    0xFE, 0x92, 0x92, 0x92, 0x82, /* ASC(69) */
-    0xFE, 0x90, 0x90, 0x90, 0x80, /* ASC(70) */
-    0x7C, 0x82, 0x82, 0x8A, 0xCE, /* ASC(71) */
-    0xFE, 0x10, 0x10, 0x10, 0xFE, /* ASC(72) */
-    0x0, 0x82, 0xFE, 0x82, 0x0, /* ASC(73) */
-    0x4, 0x2, 0x82, 0xFC, 0x80, /* ASC(74) */
-    0xFE, 0x10, 0x28, 0x44, 0x82, /* ASC(75) */
-    0xFE, 0x2, 0x2, 0x2, 0x2, /* ASC(76) */
-    0xFE, 0x40, 0x38, 0x40, 0xFE, /* ASC(77) */
-    0xFE, 0x20, 0x10, 0x8, 0xFE, /* ASC(78) */
-    0x7C, 0x82, 0x82, 0x82, 0x7C, /* ASC(79) */
-    0xFE, 0x90, 0x90, 0x90, 0x60, /* ASC(80) */
-    0x7C, 0x82, 0x8A, 0x84, 0x7A, /* ASC(81) */
-    0xFE, 0x90, 0x98, 0x94, 0x62, /* ASC(82) */
-    0x64, 0x92, 0x92, 0x92, 0x4C, /* ASC(83) */
-    0xC0, 0x80, 0xFE, 0x80, 0xC0, /* ASC(84) */
-    0xFC, 0x2, 0x2, 0x2, 0xFC, /* ASC(85) */
-    0xF8, 0x4, 0x2, 0x4, 0xF8, /* ASC(86) */
-    0xFC, 0x2, 0x1C, 0x2, 0xFC, /* ASC(87) */
-    0xC6, 0x28, 0x10, 0x28, 0xC6, /* ASC(88) */
-    0xC0, 0x20, 0x1E, 0x20, 0xC0, /* ASC(89) */
-    0x86, 0x9A, 0x92, 0xB2, 0xC2, /* ASC(90) */
-    0x0, 0xFE, 0x82, 0x82, 0x82, /* ASC(91) */
-    0x40, 0x20, 0x10, 0x8, 0x4, /* ASC(92) */
-    0x0, 0x82, 0x82, 0x82, 0xFE, /* ASC(93) */
-    0x20, 0x40, 0x80, 0x40, 0x20, /* ASC(94) */
-    0x2, 0x2, 0x2, 0x2, 0x2, /* ASC(95) */
-    0x0, 0xC0, 0xE0, 0x10, 0x0, /* ASC(96) */
-    0x4, 0x2A, 0x2A, 0x1E, 0x2, /* ASC(97) */
-    0xFE, 0x14, 0x22, 0x22, 0x1C, /* ASC(98) */
-    0x1C, 0x22, 0x22, 0x22, 0x14, /* ASC(99) */
-    0x1C, 0x22, 0x22, 0x14, 0xFE, /* ASC(100) */
-    0x1C, 0x2A, 0x2A, 0x2A, 0x18, /* ASC(101) */
-    0x0, 0x10, 0x7E, 0x90, 0x40, /* ASC(102) */
-    0x18, 0x25, 0x25, 0x39, 0x1E, /* ASC(103) */
-    0xFE, 0x10, 0x20, 0x20, 0x1E, /* ASC(104) */
-    0x0, 0x22, 0xBE, 0x2, 0x0, /* ASC(105) */
-    0x4, 0x2, 0x2, 0xBC, 0x0, /* ASC(106) */
-    0xFE, 0x8, 0x14, 0x22, 0x0, /* ASC(107) */
-    0x0, 0x82, 0xFE, 0x2, 0x0, /* ASC(108) */
-    0x3E, 0x20, 0x1E, 0x20, 0x1E, /* ASC(109) */
-    0x3E, 0x10, 0x20, 0x20, 0x1E, /* ASC(110) */
-    0x1C, 0x22, 0x22, 0x22, 0x1C, /* ASC(111) */
-    0x3F, 0x18, 0x24, 0x24, 0x18, /* ASC(112) */
-    0x18, 0x24, 0x24, 0x18, 0x3F, /* ASC(113) */
-    0x3E, 0x10, 0x20, 0x20, 0x10, /* ASC(114) */
-    0x12, 0x2A, 0x2A, 0x2A, 0x24, /* ASC(115) */
-    0x20, 0x20, 0xFC, 0x22, 0x24, /* ASC(116) */
-    0x3C, 0x2, 0x2, 0x4, 0x3E, /* ASC(117) */
-    0x38, 0x4, 0x2, 0x4, 0x38, /* ASC(118) */
-    0x3C, 0x2, 0xC, 0x2, 0x3C, /* ASC(119) */
-    0x22, 0x14, 0x8, 0x14, 0x22, /* ASC(120) */
-    0x32, 0x9, 0x9, 0x9, 0x3E, /* ASC(121) */
-    0x22, 0x26, 0x2A, 0x32, 0x22, /* ASC(122) */
-    0x0, 0x10, 0x6C, 0x82, 0x0, /* ASC(123) */
-    0x0, 0x0, 0xEE, 0x0, 0x0, /* ASC(124) */
-    0x0, 0x82, 0x6C, 0x10, 0x0, /* ASC(125) */
-    0x40, 0x80, 0x40, 0x20, 0x40, /* ASC(126) */
-#ifdef FULL_FONT
-  0x3C, 0x64, 0xC4, 0x64, 0x3C,   /* ASC(127) */
-  0x78, 0x85, 0x85, 0x86, 0x48,   /* ASC(128) */
-  0x5C, 0x2, 0x2, 0x4, 0x5E,   /* ASC(129) */
-  0x1C, 0x2A, 0x2A, 0xAA, 0x9A,   /* ASC(130) */
-  0x84, 0xAA, 0xAA, 0x9E, 0x82,   /* ASC(131) */
-  0x84, 0x2A, 0x2A, 0x1E, 0x82,   /* ASC(132) */
-  0x84, 0xAA, 0x2A, 0x1E, 0x2,   /* ASC(133) */
-  0x4, 0x2A, 0xAA, 0x9E, 0x2,   /* ASC(134) */
-  0x30, 0x78, 0x4A, 0x4E, 0x48,   /* ASC(135) */
-  0x9C, 0xAA, 0xAA, 0xAA, 0x9A,   /* ASC(136) */
-  0x9C, 0x2A, 0x2A, 0x2A, 0x9A,   /* ASC(137) */
-  0x9C, 0xAA, 0x2A, 0x2A, 0x1A,   /* ASC(138) */
-  0x0, 0x0, 0xA2, 0x3E, 0x82,   /* ASC(139) */
-  0x0, 0x40, 0xA2, 0xBE, 0x42,   /* ASC(140) */
-  0x0, 0x80, 0xA2, 0x3E, 0x2,   /* ASC(141) */
-  0xF, 0x94, 0x24, 0x94, 0xF,   /* ASC(142) */
-  0xF, 0x14, 0xA4, 0x14, 0xF,   /* ASC(143) */
-  0x3E, 0x2A, 0xAA, 0xA2, 0x0,   /* ASC(144) */
-  0x4, 0x2A, 0x2A, 0x3E, 0x2A,   /* ASC(145) */
-  0x3E, 0x50, 0x90, 0xFE, 0x92,   /* ASC(146) */
-  0x4C, 0x92, 0x92, 0x92, 0x4C,   /* ASC(147) */
-  0x4C, 0x12, 0x12, 0x12, 0x4C,   /* ASC(148) */
-  0x4C, 0x52, 0x12, 0x12, 0xC,   /* ASC(149) */
-  0x5C, 0x82, 0x82, 0x84, 0x5E,   /* ASC(150) */
-  0x5C, 0x42, 0x2, 0x4, 0x1E,   /* ASC(151) */
-  0x0, 0xB9, 0x5, 0x5, 0xBE,   /* ASC(152) */
-  0x9C, 0x22, 0x22, 0x22, 0x9C,   /* ASC(153) */
-  0xBC, 0x2, 0x2, 0x2, 0xBC,   /* ASC(154) */
-  0x3C, 0x24, 0xFF, 0x24, 0x24,   /* ASC(155) */
-  0x12, 0x7E, 0x92, 0xC2, 0x66,   /* ASC(156) */
-  0xD4, 0xF4, 0x3F, 0xF4, 0xD4,   /* ASC(157) */
-  0xFF, 0x90, 0x94, 0x6F, 0x4,   /* ASC(158) */
-  0x3, 0x11, 0x7E, 0x90, 0xC0,   /* ASC(159) */
-  0x4, 0x2A, 0x2A, 0x9E, 0x82,   /* ASC(160) */
-  0x0, 0x0, 0x22, 0xBE, 0x82,   /* ASC(161) */
-  0xC, 0x12, 0x12, 0x52, 0x4C,   /* ASC(162) */
-  0x1C, 0x2, 0x2, 0x44, 0x5E,   /* ASC(163) */
-  0x0, 0x5E, 0x50, 0x50, 0x4E,   /* ASC(164) */
-  0xBE, 0xB0, 0x98, 0x8C, 0xBE,   /* ASC(165) */
-  0x64, 0x94, 0x94, 0xF4, 0x14,   /* ASC(166) */
-  0x64, 0x94, 0x94, 0x94, 0x64,   /* ASC(167) */
-  0xC, 0x12, 0xB2, 0x2, 0x4,   /* ASC(168) */
-  0x1C, 0x10, 0x10, 0x10, 0x10,   /* ASC(169) */
-  0x10, 0x10, 0x10, 0x10, 0x1C,   /* ASC(170) */
-  0xF4, 0x8, 0x13, 0x35, 0x5D,   /* ASC(171) */
-  0xF4, 0x8, 0x14, 0x2C, 0x5F,   /* ASC(172) */
-  0x0, 0x0, 0xDE, 0x0, 0x0,   /* ASC(173) */
-  0x10, 0x28, 0x54, 0x28, 0x44,   /* ASC(174) */
-  0x44, 0x28, 0x54, 0x28, 0x10,   /* ASC(175) */
-  0x55, 0x0, 0xAA, 0x0, 0x55,   /* ASC(176) */
-  0x55, 0xAA, 0x55, 0xAA, 0x55,   /* ASC(177) */
-  0xAA, 0x55, 0xAA, 0x55, 0xAA,   /* ASC(178) */
-  0x0, 0x0, 0x0, 0xFF, 0x0,   /* ASC(179) */
-  0x8, 0x8, 0x8, 0xFF, 0x0,   /* ASC(180) */
-  0x28, 0x28, 0x28, 0xFF, 0x0,   /* ASC(181) */
-  0x8, 0x8, 0xFF, 0x0, 0xFF,   /* ASC(182) */
-  0x8, 0x8, 0xF, 0x8, 0xF,   /* ASC(183) */
-  0x28, 0x28, 0x28, 0x3F, 0x0,   /* ASC(184) */
-  0x28, 0x28, 0xEF, 0x0, 0xFF,   /* ASC(185) */
-  0x0, 0x0, 0xFF, 0x0, 0xFF,   /* ASC(186) */
-  0x28, 0x28, 0x2F, 0x20, 0x3F,   /* ASC(187) */
-  0x28, 0x28, 0xE8, 0x8, 0xF8,   /* ASC(188) */
-  0x8, 0x8, 0xF8, 0x8, 0xF8,   /* ASC(189) */
-  0x28, 0x28, 0x28, 0xF8, 0x0,   /* ASC(190) */
-  0x8, 0x8, 0x8, 0xF, 0x0,   /* ASC(191) */
-  0x0, 0x0, 0x0, 0xF8, 0x8,   /* ASC(192) */
-  0x8, 0x8, 0x8, 0xF8, 0x8,   /* ASC(193) */
-  0x8, 0x8, 0x8, 0xF, 0x8,   /* ASC(194) */
-  0x0, 0x0, 0x0, 0xFF, 0x8,   /* ASC(195) */
-  0x8, 0x8, 0x8, 0x8, 0x8,   /* ASC(196) */
-  0x8, 0x8, 0x8, 0xFF, 0x8,   /* ASC(197) */
-  0x0, 0x0, 0x0, 0xFF, 0x28,   /* ASC(198) */
-  0x0, 0x0, 0xFF, 0x0, 0xFF,   /* ASC(199) */
-  0x0, 0x0, 0xF8, 0x8, 0xE8,   /* ASC(200) */
-  0x0, 0x0, 0x3F, 0x20, 0x2F,   /* ASC(201) */
-  0x28, 0x28, 0xE8, 0x8, 0xE8,   /* ASC(202) */
-  0x28, 0x28, 0x2F, 0x20, 0x2F,   /* ASC(203) */
-  0x0, 0x0, 0xFF, 0x0, 0xEF,   /* ASC(204) */
-  0x28, 0x28, 0x28, 0x28, 0x28,   /* ASC(205) */
-  0x28, 0x28, 0xEF, 0x0, 0xEF,   /* ASC(206) */
-  0x28, 0x28, 0x28, 0xE8, 0x28,   /* ASC(207) */
-  0x8, 0x8, 0xF8, 0x8, 0xF8,   /* ASC(208) */
-  0x28, 0x28, 0x28, 0x2F, 0x28,   /* ASC(209) */
-  0x8, 0x8, 0xF, 0x8, 0xF,   /* ASC(210) */
-  0x0, 0x0, 0xF8, 0x8, 0xF8,   /* ASC(211) */
-  0x0, 0x0, 0x0, 0xF8, 0x28,   /* ASC(212) */
-  0x0, 0x0, 0x0, 0x3F, 0x28,   /* ASC(213) */
-  0x0, 0x0, 0xF, 0x8, 0xF,   /* ASC(214) */
-  0x8, 0x8, 0xFF, 0x8, 0xFF,   /* ASC(215) */
-  0x28, 0x28, 0x28, 0xFF, 0x28,   /* ASC(216) */
-  0x8, 0x8, 0x8, 0xF8, 0x0,   /* ASC(217) */
-  0x0, 0x0, 0x0, 0xF, 0x8,   /* ASC(218) */
-  0xFF, 0xFF, 0xFF, 0xFF, 0xFF,   /* ASC(219) */
-  0xF, 0xF, 0xF, 0xF, 0xF,   /* ASC(220) */
-  0xFF, 0xFF, 0xFF, 0x0, 0x0,   /* ASC(221) */
-  0x0, 0x0, 0x0, 0xFF, 0xFF,   /* ASC(222) */
-  0xF0, 0xF0, 0xF0, 0xF0, 0xF0,   /* ASC(223) */
-  0x1C, 0x22, 0x22, 0x1C, 0x22,   /* ASC(224) */
-  0x3E, 0x54, 0x54, 0x7C, 0x28,   /* ASC(225) */
-  0x7E, 0x40, 0x40, 0x60, 0x60,   /* ASC(226) */
-  0x40, 0x7E, 0x40, 0x7E, 0x40,   /* ASC(227) */
-  0xC6, 0xAA, 0x92, 0x82, 0xC6,   /* ASC(228) */
-  0x1C, 0x22, 0x22, 0x3C, 0x20,   /* ASC(229) */
-  0x2, 0x7E, 0x4, 0x78, 0x4,   /* ASC(230) */
-  0x60, 0x40, 0x7E, 0x40, 0x40,   /* ASC(231) */
-  0x99, 0xA5, 0xE7, 0xA5, 0x99,   /* ASC(232) */
-  0x38, 0x54, 0x92, 0x54, 0x38,   /* ASC(233) */
-  0x32, 0x4E, 0x80, 0x4E, 0x32,   /* ASC(234) */
-  0xC, 0x52, 0xB2, 0xB2, 0xC,   /* ASC(235) */
-  0xC, 0x12, 0x1E, 0x12, 0xC,   /* ASC(236) */
-  0x3D, 0x46, 0x5A, 0x62, 0xBC,   /* ASC(237) */
-  0x7C, 0x92, 0x92, 0x92, 0x0,   /* ASC(238) */
-  0x7E, 0x80, 0x80, 0x80, 0x7E,   /* ASC(239) */
-  0x54, 0x54, 0x54, 0x54, 0x54,   /* ASC(240) */
-  0x22, 0x22, 0xFA, 0x22, 0x22,   /* ASC(241) */
-  0x2, 0x8A, 0x52, 0x22, 0x2,   /* ASC(242) */
-  0x2, 0x22, 0x52, 0x8A, 0x2,   /* ASC(243) */
-  0x0, 0x0, 0xFF, 0x80, 0xC0,   /* ASC(244) */
-  0x7, 0x1, 0xFF, 0x0, 0x0,   /* ASC(245) */
-  0x10, 0x10, 0xD6, 0xD6, 0x10,   /* ASC(246) */
-  0x6C, 0x48, 0x6C, 0x24, 0x6C,   /* ASC(247) */
-  0x60, 0xF0, 0x90, 0xF0, 0x60,   /* ASC(248) */
-  0x0, 0x0, 0x18, 0x18, 0x0,   /* ASC(249) */
-  0x0, 0x0, 0x8, 0x8, 0x0,   /* ASC(250) */
-  0xC, 0x2, 0xFF, 0x80, 0x80,   /* ASC(251) */
-  0x0, 0xF8, 0x80, 0x80, 0x78,   /* ASC(252) */
-  0x0, 0x98, 0xB8, 0xE8, 0x48,   /* ASC(253) */
-  0x0, 0x3C, 0x3C, 0x3C, 0x3C,   /* ASC(254) */
-#endif
-    };
-
 /************************************************************************/
 /* LCD Parameters                                                       */
 /************************************************************************/
@@ -437,12 +195,8 @@ static const uint8_t gca_font[] =
 #define ST7565_LCD_MASK_ROWS                 0x07
 #define ST7565_LCD_MAX_COLUMNS               ST7565_LCD_PARAM_WIDTH
 #define ST7565_LCD_MASK_COLUMNS              0x7F
-
-#ifdef ADAFRUIT_ST7565_LCD
-#define ST7565_LCD_PARAM_BRIGHTNESS          0x18
-#else
-#define ST7565_LCD_PARAM_BRIGHTNESS          0x0
-#endif
+/* Columns in the Controller display RAM (0x00 - 0x83) */
+#define ST7565_LCD_RAM_COLUMNS               132U
 
 #define ST7565_LCD_PARAM_FONT_WIDTH          5
 #define ST7565_LCD_PARAM_FONT_CHARWIDTH      7
@@ -456,6 +210,457 @@ static const uint8_t gca_font[] =
 #define ST7565_LCD_PARAM_FONT_CHAR_MAXVAL    255
 #endif   
 #define ST7565_LCD_PARAM_SPISPEED            20000000UL
+/* Unix domain socket used by the daemon mode */
+#ifndef ST7565_LCD_PARAM_SOCKET
+#define ST7565_LCD_PARAM_SOCKET              "/tmp/lcdST7565.sock"
+#endif
+/* State kept between the runs, '.N' is added for Display N - Should be
+   on a tmpfs, it is then gone with a power cycle as is the LCD setup */
+#ifndef ST7565_LCD_PARAM_STATE
+#define ST7565_LCD_PARAM_STATE               "/run/lcdST7565.state"
+#endif
+/* Panel profiles added to the built-in ones - see Panel Profiles */
+#ifndef ST7565_LCD_PARAM_PANELS
+#define ST7565_LCD_PARAM_PANELS              "/etc/lcdST7565.conf"
+#endif
+
+/************************************************************************/
+/* Panel Profiles                                                       */
+/************************************************************************/
+
+/*
+  The panels built with the ST7565 differ in how the controller RAM is
+  wired to the glass. A profile describes one panel, so the same program
+  drives all of them:
+  - columns / pages   : Visible size, pages can be 9 when the Icon page
+                        is a visible line (Adafruit)
+  - offset            : Controller column of the first visible column
+  - page_map          : Controller page of each text row (and the Icon
+                        row) with the Start Line at 0
+  - bias, contrast, adc, com, ratio : Setup sent by lcd_init
+  - rotate, mirror    : Orientation of the picture (see Orientation)
+  'generic' and 'adafruit' are built in, more can be defined in the file
+  ST7565_LCD_PARAM_PANELS (or the environment variable LCD_PANELS):
+    # Comment
+    display1 = adafruit    Profile of Display 1 (Default as built)
+    [mypanel]              Starts a profile - the generic one till set
+    columns = 128
+    pages = 8
+    offset = 4
+    page_map = 0 1 2 3 4 5 6 7 8
+    bias = 9               1/9 or 1/7
+    contrast = 0x20        0 - 63
+    adc = reverse          normal | reverse
+    com = normal           normal | reverse
+    ratio = 6              Regulator resistor ratio 0 - 7
+    rotate = 180           0 | 90 | 180 | 270 degrees
+    mirror = off           on | off
+  The environment variable LCD_PANEL picks the profile for all the
+  Displays. The mapping is turned into lookup tables when a profile is
+  taken, the addressing itself then has no panel cases.
+*/
+
+/* Pages of the controller RAM - 8 Pages + Icon Page */
+#define ST7565_LCD_PANEL_PAGES               (ST7565_LCD_MAX_ROWS + 1)
+/* Profiles that can be defined in the file */
+#define ST7565_LCD_PANEL_FILE_MAX            8
+/* Longest profile name */
+#define ST7565_LCD_PANEL_NAME                16
+
+typedef struct
+{
+  char     name[ST7565_LCD_PANEL_NAME];
+  uint8_t  columns;
+  uint8_t  pages;
+  uint8_t  offset;
+  uint8_t  page_map[ST7565_LCD_PANEL_PAGES];
+  uint8_t  bias;        /* 7 or 9 */
+  uint8_t  contrast;
+  uint8_t  adc_reverse;
+  uint8_t  com_reverse;
+  uint8_t  ratio;
+  uint8_t  rotate;      /* Quarter turns */
+  uint8_t  mirror;
+} lcd_panel_t;
+
+/* Built-in profiles */
+static const lcd_panel_t gca_panels[] =
+{
+  { "generic",  ST7565_LCD_MAX_COLUMNS, ST7565_LCD_MAX_ROWS, 0,
+    { 7, 6, 5, 4, 3, 2, 1, 0, 8 }, 7, 0x00, 0, 0, 7, 0, 0 },
+  /* The two halves of the page order are swapped, and the Icon page
+     is an additional line shown through page 3 */
+  { "adafruit", ST7565_LCD_MAX_COLUMNS, ST7565_LCD_MAX_ROWS + 1, 1,
+    { 3, 2, 1, 0, 7, 6, 5, 4, 3 }, 7, 0x18, 0, 0, 7, 0, 0 },
+};
+
+/* Profile of the Displays unless configured */
+#ifdef ADAFRUIT_ST7565_LCD
+#define ST7565_LCD_PANEL_DEFAULT             (&gca_panels[1])
+#else
+#define ST7565_LCD_PANEL_DEFAULT             (&gca_panels[0])
+#endif
+
+/************************************************************************/
+/* Font Definitions                                                     */
+/************************************************************************/
+/**
+ * 5x7 LCD font 'flipped' for the ST7565 - public domain
+ * @note This is a 256 character font. Delete glyphs in order to save Flash
+ * 
+ * Each glyph is stored pre-expanded to the full character width - the
+ * spacing columns are filled with zeros by the compiler, so a glyph can
+ * be copied to the LCD as it is.
+ */
+/* Controls the definition of the Font array and character spcing */
+//#define FULL_FONT
+static const uint8_t gca_font[][ST7565_LCD_PARAM_FONT_CHARWIDTH] =
+{
+#ifdef FULL_FONT
+  {0x0, 0x0, 0x0, 0x0, 0x0},          /* ASC(00) */
+  {0x7C, 0xDA, 0xF2, 0xDA, 0x7C},     /* ASC(01) */
+  {0x7C, 0xD6, 0xF2, 0xD6, 0x7C},     /* ASC(02) */
+  {0x38, 0x7C, 0x3E, 0x7C, 0x38},   /* ASC(03) */
+  {0x18, 0x3C, 0x7E, 0x3C, 0x18},   /* ASC(04) */
+  {0x38, 0xEA, 0xBE, 0xEA, 0x38},   /* ASC(05) */
+  {0x38, 0x7A, 0xFE, 0x7A, 0x38},   /* ASC(06) */
+  {0x0, 0x18, 0x3C, 0x18, 0x0},   /* ASC(07) */
+  {0xFF, 0xE7, 0xC3, 0xE7, 0xFF},   /* ASC(08) */
+  {0x0, 0x18, 0x24, 0x18, 0x0},   /* ASC(09) */
+  {0xFF, 0xE7, 0xDB, 0xE7, 0xFF},   /* ASC(10) */
+  {0xC, 0x12, 0x5C, 0x60, 0x70},   /* ASC(11) */
+  {0x64, 0x94, 0x9E, 0x94, 0x64},   /* ASC(12) */
+  {0x2, 0xFE, 0xA0, 0xA0, 0xE0},   /* ASC(13) */
+  {0x2, 0xFE, 0xA0, 0xA4, 0xFC},   /* ASC(14) */
+  {0x5A, 0x3C, 0xE7, 0x3C, 0x5A},   /* ASC(15) */
+  {0xFE, 0x7C, 0x38, 0x38, 0x10},   /* ASC(16) */
+  {0x10, 0x38, 0x38, 0x7C, 0xFE},   /* ASC(17) */
+  {0x28, 0x44, 0xFE, 0x44, 0x28},   /* ASC(18) */
+  {0xFA, 0xFA, 0x0, 0xFA, 0xFA},   /* ASC(19) */
+  {0x60, 0x90, 0xFE, 0x80, 0xFE},   /* ASC(20) */
+  {0x0, 0x66, 0x91, 0xA9, 0x56},   /* ASC(21) */
+  {0x6, 0x6, 0x6, 0x6, 0x6},   /* ASC(22) */
+  {0x29, 0x45, 0xFF, 0x45, 0x29},   /* ASC(23) */
+  {0x10, 0x20, 0x7E, 0x20, 0x10},   /* ASC(24) */
+  {0x8, 0x4, 0x7E, 0x4, 0x8},   /* ASC(25) */
+  {0x10, 0x10, 0x54, 0x38, 0x10},   /* ASC(26) */
+  {0x10, 0x38, 0x54, 0x10, 0x10},   /* ASC(27) */
+  {0x78, 0x8, 0x8, 0x8, 0x8},   /* ASC(28) */
+  {0x30, 0x78, 0x30, 0x78, 0x30},   /* ASC(29) */
+  {0xC, 0x1C, 0x7C, 0x1C, 0xC},   /* ASC(30) */
+  {0x60, 0x70, 0x7C, 0x70, 0x60},   /* ASC(31) */
+#endif
+    {0x0, 0x0, 0x0, 0x0, 0x0}, /* ASC(32) */
+    {0x0, 0x0, 0xFA, 0x0, 0x0}, /* ASC(33) */
+    {0x0, 0xE0, 0x0, 0xE0, 0x0}, /* ASC(34) */
+    {0x28, 0xFE, 0x28, 0xFE, 0x28}, /* ASC(35) */
+    {0x24, 0x54, 0xFE, 0x54, 0x48}, /* ASC(36) */
+    {0xC4, 0xC8, 0x10, 0x26, 0x46}, /* ASC(37) */
+    {0x6C, 0x92, 0x6A, 0x4, 0xA}, /* ASC(38) */
+    {0x0, 0x10, 0xE0, 0xC0, 0x0}, /* ASC(39) */
+    {0x0, 0x38, 0x44, 0x82, 0x0}, /* ASC(40) */
+    {0x0, 0x82, 0x44, 0x38, 0x0}, /* ASC(41) */
+    {0x54, 0x38, 0xFE, 0x38, 0x54}, /* ASC(42) */
+    {0x10, 0x10, 0x7C, 0x10, 0x10}, /* ASC(43) */
+    {0x0, 0x1, 0xE, 0xC, 0x0}, /* ASC(44) */
+    {0x10, 0x10, 0x10, 0x10, 0x10}, /* ASC(45) */
+    {0x0, 0x0, 0x6, 0x6, 0x0}, /* ASC(46) */
+    {0x4, 0x8, 0x10, 0x20, 0x40}, /* ASC(47) */
+    {0x7C, 0x8A, 0x92, 0xA2, 0x7C}, /* ASC(48) */
+    {0x0, 0x42, 0xFE, 0x2, 0x0}, /* ASC(49) */
+    {0x4E, 0x92, 0x92, 0x92, 0x62}, /* ASC(50) */
+    {0x84, 0x82, 0x92, 0xB2, 0xCC}, /* ASC(51) */
+    {0x18, 0x28, 0x48, 0xFE, 0x8}, /* ASC(52) */
+    {0xE4, 0xA2, 0xA2, 0xA2, 0x9C}, /* ASC(53) */
+    {0x3C, 0x52, 0x92, 0x92, 0x8C}, /* ASC(54) */
+    {0x82, 0x84, 0x88, 0x90, 0xE0}, /* ASC(55) */
+    {0x6C, 0x92, 0x92, 0x92, 0x6C}, /* ASC(56) */
+    {0x62, 0x92, 0x92, 0x94, 0x78}, /* ASC(57) */
+    {0x0, 0x0, 0x28, 0x0, 0x0}, /* ASC(58) */
+    {0x0, 0x2, 0x2C, 0x0, 0x0}, /* ASC(59) */
+    {0x0, 0x10, 0x28, 0x44, 0x82}, /* ASC(60) */
+    {0x28, 0x28, 0x28, 0x28, 0x28}, /* ASC(61) */
+    {0x0, 0x82, 0x44, 0x28, 0x10}, /* ASC(62) */
+    {0x40, 0x80, 0x9A, 0x90, 0x60}, /* ASC(63) */
+    {0x7C, 0x82, 0xBA, 0x9A, 0x72}, /* ASC(64) */
+    {0x3E, 0x48, 0x88, 0x48, 0x3E}, /* ASC(65) */
+    {0xFE, 0x92, 0x92, 0x92, 0x6C}, /* ASC(66) */
+    {0x7C, 0x82, 0x82, 0x82, 0x44}, /* ASC(67) */
+    {0xFE, 0x82, 0x82, 0x82, 0x7C}, /* ASC(68) */
+    {0xFE, 0x92, 0x92, 0x92, 0x82}, /* ASC(69) */
+    {0xFE, 0x90, 0x90, 0x90, 0x80}, /* ASC(70) */
+    {0x7C, 0x82, 0x82, 0x8A, 0xCE}, /* ASC(71) */
+    {0xFE, 0x10, 0x10, 0x10, 0xFE}, /* ASC(72) */
+    {0x0, 0x82, 0xFE, 0x82, 0x0}, /* ASC(73) */
+    {0x4, 0x2, 0x82, 0xFC, 0x80}, /* ASC(74) */
+    {0xFE, 0x10, 0x28, 0x44, 0x82}, /* ASC(75) */
+    {0xFE, 0x2, 0x2, 0x2, 0x2}, /* ASC(76) */
+    {0xFE, 0x40, 0x38, 0x40, 0xFE}, /* ASC(77) */
+    {0xFE, 0x20, 0x10, 0x8, 0xFE}, /* ASC(78) */
+    {0x7C, 0x82, 0x82, 0x82, 0x7C}, /* ASC(79) */
+    {0xFE, 0x90, 0x90, 0x90, 0x60}, /* ASC(80) */
+    {0x7C, 0x82, 0x8A, 0x84, 0x7A}, /* ASC(81) */
+    {0xFE, 0x90, 0x98, 0x94, 0x62}, /* ASC(82) */
+    {0x64, 0x92, 0x92, 0x92, 0x4C}, /* ASC(83) */
+    {0xC0, 0x80, 0xFE, 0x80, 0xC0}, /* ASC(84) */
+    {0xFC, 0x2, 0x2, 0x2, 0xFC}, /* ASC(85) */
+    {0xF8, 0x4, 0x2, 0x4, 0xF8}, /* ASC(86) */
+    {0xFC, 0x2, 0x1C, 0x2, 0xFC}, /* ASC(87) */
+    {0xC6, 0x28, 0x10, 0x28, 0xC6}, /* ASC(88) */
+    {0xC0, 0x20, 0x1E, 0x20, 0xC0}, /* ASC(89) */
+    {0x86, 0x9A, 0x92, 0xB2, 0xC2}, /* ASC(90) */
+    {0x0, 0xFE, 0x82, 0x82, 0x82}, /* ASC(91) */
+    {0x40, 0x20, 0x10, 0x8, 0x4}, /* ASC(92) */
+    {0x0, 0x82, 0x82, 0x82, 0xFE}, /* ASC(93) */
+    {0x20, 0x40, 0x80, 0x40, 0x20}, /* ASC(94) */
+    {0x2, 0x2, 0x2, 0x2, 0x2}, /* ASC(95) */
+    {0x0, 0xC0, 0xE0, 0x10, 0x0}, /* ASC(96) */
+    {0x4, 0x2A, 0x2A, 0x1E, 0x2}, /* ASC(97) */
+    {0xFE, 0x14, 0x22, 0x22, 0x1C}, /* ASC(98) */
+    {0x1C, 0x22, 0x22, 0x22, 0x14}, /* ASC(99) */
+    {0x1C, 0x22, 0x22, 0x14, 0xFE}, /* ASC(100) */
+    {0x1C, 0x2A, 0x2A, 0x2A, 0x18}, /* ASC(101) */
+    {0x0, 0x10, 0x7E, 0x90, 0x40}, /* ASC(102) */
+    {0x18, 0x25, 0x25, 0x39, 0x1E}, /* ASC(103) */
+    {0xFE, 0x10, 0x20, 0x20, 0x1E}, /* ASC(104) */
+    {0x0, 0x22, 0xBE, 0x2, 0x0}, /* ASC(105) */
+    {0x4, 0x2, 0x2, 0xBC, 0x0}, /* ASC(106) */
+    {0xFE, 0x8, 0x14, 0x22, 0x0}, /* ASC(107) */
+    {0x0, 0x82, 0xFE, 0x2, 0x0}, /* ASC(108) */
+    {0x3E, 0x20, 0x1E, 0x20, 0x1E}, /* ASC(109) */
+    {0x3E, 0x10, 0x20, 0x20, 0x1E}, /* ASC(110) */
+    {0x1C, 0x22, 0x22, 0x22, 0x1C}, /* ASC(111) */
+    {0x3F, 0x18, 0x24, 0x24, 0x18}, /* ASC(112) */
+    {0x18, 0x24, 0x24, 0x18, 0x3F}, /* ASC(113) */
+    {0x3E, 0x10, 0x20, 0x20, 0x10}, /* ASC(114) */
+    {0x12, 0x2A, 0x2A, 0x2A, 0x24}, /* ASC(115) */
+    {0x20, 0x20, 0xFC, 0x22, 0x24}, /* ASC(116) */
+    {0x3C, 0x2, 0x2, 0x4, 0x3E}, /* ASC(117) */
+    {0x38, 0x4, 0x2, 0x4, 0x38}, /* ASC(118) */
+    {0x3C, 0x2, 0xC, 0x2, 0x3C}, /* ASC(119) */
+    {0x22, 0x14, 0x8, 0x14, 0x22}, /* ASC(120) */
+    {0x32, 0x9, 0x9, 0x9, 0x3E}, /* ASC(121) */
+    {0x22, 0x26, 0x2A, 0x32, 0x22}, /* ASC(122) */
+    {0x0, 0x10, 0x6C, 0x82, 0x0}, /* ASC(123) */
+    {0x0, 0x0, 0xEE, 0x0, 0x0}, /* ASC(124) */
+    {0x0, 0x82, 0x6C, 0x10, 0x0}, /* ASC(125) */
+    {0x40, 0x80, 0x40, 0x20, 0x40}, /* ASC(126) */
+#ifdef FULL_FONT
+  {0x3C, 0x64, 0xC4, 0x64, 0x3C},   /* ASC(127) */
+  {0x78, 0x85, 0x85, 0x86, 0x48},   /* ASC(128) */
+  {0x5C, 0x2, 0x2, 0x4, 0x5E},   /* ASC(129) */
+  {0x1C, 0x2A, 0x2A, 0xAA, 0x9A},   /* ASC(130) */
+  {0x84, 0xAA, 0xAA, 0x9E, 0x82},   /* ASC(131) */
+  {0x84, 0x2A, 0x2A, 0x1E, 0x82},   /* ASC(132) */
+  {0x84, 0xAA, 0x2A, 0x1E, 0x2},   /* ASC(133) */
+  {0x4, 0x2A, 0xAA, 0x9E, 0x2},   /* ASC(134) */
+  {0x30, 0x78, 0x4A, 0x4E, 0x48},   /* ASC(135) */
+  {0x9C, 0xAA, 0xAA, 0xAA, 0x9A},   /* ASC(136) */
+  {0x9C, 0x2A, 0x2A, 0x2A, 0x9A},   /* ASC(137) */
+  {0x9C, 0xAA, 0x2A, 0x2A, 0x1A},   /* ASC(138) */
+  {0x0, 0x0, 0xA2, 0x3E, 0x82},   /* ASC(139) */
+  {0x0, 0x40, 0xA2, 0xBE, 0x42},   /* ASC(140) */
+  {0x0, 0x80, 0xA2, 0x3E, 0x2},   /* ASC(141) */
+  {0xF, 0x94, 0x24, 0x94, 0xF},   /* ASC(142) */
+  {0xF, 0x14, 0xA4, 0x14, 0xF},   /* ASC(143) */
+  {0x3E, 0x2A, 0xAA, 0xA2, 0x0},   /* ASC(144) */
+  {0x4, 0x2A, 0x2A, 0x3E, 0x2A},   /* ASC(145) */
+  {0x3E, 0x50, 0x90, 0xFE, 0x92},   /* ASC(146) */
+  {0x4C, 0x92, 0x92, 0x92, 0x4C},   /* ASC(147) */
+  {0x4C, 0x12, 0x12, 0x12, 0x4C},   /* ASC(148) */
+  {0x4C, 0x52, 0x12, 0x12, 0xC},   /* ASC(149) */
+  {0x5C, 0x82, 0x82, 0x84, 0x5E},   /* ASC(150) */
+  {0x5C, 0x42, 0x2, 0x4, 0x1E},   /* ASC(151) */
+  {0x0, 0xB9, 0x5, 0x5, 0xBE},   /* ASC(152) */
+  {0x9C, 0x22, 0x22, 0x22, 0x9C},   /* ASC(153) */
+  {0xBC, 0x2, 0x2, 0x2, 0xBC},   /* ASC(154) */
+  {0x3C, 0x24, 0xFF, 0x24, 0x24},   /* ASC(155) */
+  {0x12, 0x7E, 0x92, 0xC2, 0x66},   /* ASC(156) */
+  {0xD4, 0xF4, 0x3F, 0xF4, 0xD4},   /* ASC(157) */
+  {0xFF, 0x90, 0x94, 0x6F, 0x4},   /* ASC(158) */
+  {0x3, 0x11, 0x7E, 0x90, 0xC0},   /* ASC(159) */
+  {0x4, 0x2A, 0x2A, 0x9E, 0x82},   /* ASC(160) */
+  {0x0, 0x0, 0x22, 0xBE, 0x82},   /* ASC(161) */
+  {0xC, 0x12, 0x12, 0x52, 0x4C},   /* ASC(162) */
+  {0x1C, 0x2, 0x2, 0x44, 0x5E},   /* ASC(163) */
+  {0x0, 0x5E, 0x50, 0x50, 0x4E},   /* ASC(164) */
+  {0xBE, 0xB0, 0x98, 0x8C, 0xBE},   /* ASC(165) */
+  {0x64, 0x94, 0x94, 0xF4, 0x14},   /* ASC(166) */
+  {0x64, 0x94, 0x94, 0x94, 0x64},   /* ASC(167) */
+  {0xC, 0x12, 0xB2, 0x2, 0x4},   /* ASC(168) */
+  {0x1C, 0x10, 0x10, 0x10, 0x10},   /* ASC(169) */
+  {0x10, 0x10, 0x10, 0x10, 0x1C},   /* ASC(170) */
+  {0xF4, 0x8, 0x13, 0x35, 0x5D},   /* ASC(171) */
+  {0xF4, 0x8, 0x14, 0x2C, 0x5F},   /* ASC(172) */
+  {0x0, 0x0, 0xDE, 0x0, 0x0},   /* ASC(173) */
+  {0x10, 0x28, 0x54, 0x28, 0x44},   /* ASC(174) */
+  {0x44, 0x28, 0x54, 0x28, 0x10},   /* ASC(175) */
+  {0x55, 0x0, 0xAA, 0x0, 0x55},   /* ASC(176) */
+  {0x55, 0xAA, 0x55, 0xAA, 0x55},   /* ASC(177) */
+  {0xAA, 0x55, 0xAA, 0x55, 0xAA},   /* ASC(178) */
+  {0x0, 0x0, 0x0, 0xFF, 0x0},   /* ASC(179) */
+  {0x8, 0x8, 0x8, 0xFF, 0x0},   /* ASC(180) */
+  {0x28, 0x28, 0x28, 0xFF, 0x0},   /* ASC(181) */
+  {0x8, 0x8, 0xFF, 0x0, 0xFF},   /* ASC(182) */
+  {0x8, 0x8, 0xF, 0x8, 0xF},   /* ASC(183) */
+  {0x28, 0x28, 0x28, 0x3F, 0x0},   /* ASC(184) */
+  {0x28, 0x28, 0xEF, 0x0, 0xFF},   /* ASC(185) */
+  {0x0, 0x0, 0xFF, 0x0, 0xFF},   /* ASC(186) */
+  {0x28, 0x28, 0x2F, 0x20, 0x3F},   /* ASC(187) */
+  {0x28, 0x28, 0xE8, 0x8, 0xF8},   /* ASC(188) */
+  {0x8, 0x8, 0xF8, 0x8, 0xF8},   /* ASC(189) */
+  {0x28, 0x28, 0x28, 0xF8, 0x0},   /* ASC(190) */
+  {0x8, 0x8, 0x8, 0xF, 0x0},   /* ASC(191) */
+  {0x0, 0x0, 0x0, 0xF8, 0x8},   /* ASC(192) */
+  {0x8, 0x8, 0x8, 0xF8, 0x8},   /* ASC(193) */
+  {0x8, 0x8, 0x8, 0xF, 0x8},   /* ASC(194) */
+  {0x0, 0x0, 0x0, 0xFF, 0x8},   /* ASC(195) */
+  {0x8, 0x8, 0x8, 0x8, 0x8},   /* ASC(196) */
+  {0x8, 0x8, 0x8, 0xFF, 0x8},   /* ASC(197) */
+  {0x0, 0x0, 0x0, 0xFF, 0x28},   /* ASC(198) */
+  {0x0, 0x0, 0xFF, 0x0, 0xFF},   /* ASC(199) */
+  {0x0, 0x0, 0xF8, 0x8, 0xE8},   /* ASC(200) */
+  {0x0, 0x0, 0x3F, 0x20, 0x2F},   /* ASC(201) */
+  {0x28, 0x28, 0xE8, 0x8, 0xE8},   /* ASC(202) */
+  {0x28, 0x28, 0x2F, 0x20, 0x2F},   /* ASC(203) */
+  {0x0, 0x0, 0xFF, 0x0, 0xEF},   /* ASC(204) */
+  {0x28, 0x28, 0x28, 0x28, 0x28},   /* ASC(205) */
+  {0x28, 0x28, 0xEF, 0x0, 0xEF},   /* ASC(206) */
+  {0x28, 0x28, 0x28, 0xE8, 0x28},   /* ASC(207) */
+  {0x8, 0x8, 0xF8, 0x8, 0xF8},   /* ASC(208) */
+  {0x28, 0x28, 0x28, 0x2F, 0x28},   /* ASC(209) */
+  {0x8, 0x8, 0xF, 0x8, 0xF},   /* ASC(210) */
+  {0x0, 0x0, 0xF8, 0x8, 0xF8},   /* ASC(211) */
+  {0x0, 0x0, 0x0, 0xF8, 0x28},   /* ASC(212) */
+  {0x0, 0x0, 0x0, 0x3F, 0x28},   /* ASC(213) */
+  {0x0, 0x0, 0xF, 0x8, 0xF},   /* ASC(214) */
+  {0x8, 0x8, 0xFF, 0x8, 0xFF},   /* ASC(215) */
+  {0x28, 0x28, 0x28, 0xFF, 0x28},   /* ASC(216) */
+  {0x8, 0x8, 0x8, 0xF8, 0x0},   /* ASC(217) */
+  {0x0, 0x0, 0x0, 0xF, 0x8},   /* ASC(218) */
+  {0xFF, 0xFF, 0xFF, 0xFF, 0xFF},   /* ASC(219) */
+  {0xF, 0xF, 0xF, 0xF, 0xF},   /* ASC(220) */
+  {0xFF, 0xFF, 0xFF, 0x0, 0x0},   /* ASC(221) */
+  {0x0, 0x0, 0x0, 0xFF, 0xFF},   /* ASC(222) */
+  {0xF0, 0xF0, 0xF0, 0xF0, 0xF0},   /* ASC(223) */
+  {0x1C, 0x22, 0x22, 0x1C, 0x22},   /* ASC(224) */
+  {0x3E, 0x54, 0x54, 0x7C, 0x28},   /* ASC(225) */
+  {0x7E, 0x40, 0x40, 0x60, 0x60},   /* ASC(226) */
+  {0x40, 0x7E, 0x40, 0x7E, 0x40},   /* ASC(227) */
+  {0xC6, 0xAA, 0x92, 0x82, 0xC6},   /* ASC(228) */
+  {0x1C, 0x22, 0x22, 0x3C, 0x20},   /* ASC(229) */
+  {0x2, 0x7E, 0x4, 0x78, 0x4},   /* ASC(230) */
+  {0x60, 0x40, 0x7E, 0x40, 0x40},   /* ASC(231) */
+  {0x99, 0xA5, 0xE7, 0xA5, 0x99},   /* ASC(232) */
+  {0x38, 0x54, 0x92, 0x54, 0x38},   /* ASC(233) */
+  {0x32, 0x4E, 0x80, 0x4E, 0x32},   /* ASC(234) */
+  {0xC, 0x52, 0xB2, 0xB2, 0xC},   /* ASC(235) */
+  {0xC, 0x12, 0x1E, 0x12, 0xC},   /* ASC(236) */
+  {0x3D, 0x46, 0x5A, 0x62, 0xBC},   /* ASC(237) */
+  {0x7C, 0x92, 0x92, 0x92, 0x0},   /* ASC(238) */
+  {0x7E, 0x80, 0x80, 0x80, 0x7E},   /* ASC(239) */
+  {0x54, 0x54, 0x54, 0x54, 0x54},   /* ASC(240) */
+  {0x22, 0x22, 0xFA, 0x22, 0x22},   /* ASC(241) */
+  {0x2, 0x8A, 0x52, 0x22, 0x2},   /* ASC(242) */
+  {0x2, 0x22, 0x52, 0x8A, 0x2},   /* ASC(243) */
+  {0x0, 0x0, 0xFF, 0x80, 0xC0},   /* ASC(244) */
+  {0x7, 0x1, 0xFF, 0x0, 0x0},   /* ASC(245) */
+  {0x10, 0x10, 0xD6, 0xD6, 0x10},   /* ASC(246) */
+  {0x6C, 0x48, 0x6C, 0x24, 0x6C},   /* ASC(247) */
+  {0x60, 0xF0, 0x90, 0xF0, 0x60},   /* ASC(248) */
+  {0x0, 0x0, 0x18, 0x18, 0x0},   /* ASC(249) */
+  {0x0, 0x0, 0x8, 0x8, 0x0},   /* ASC(250) */
+  {0xC, 0x2, 0xFF, 0x80, 0x80},   /* ASC(251) */
+  {0x0, 0xF8, 0x80, 0x80, 0x78},   /* ASC(252) */
+  {0x0, 0x98, 0xB8, 0xE8, 0x48},   /* ASC(253) */
+  {0x0, 0x3C, 0x3C, 0x3C, 0x3C},   /* ASC(254) */
+#endif
+    };
+
+/*
+  Fonts - Any number of fonts can be built in, font 0 is the 5x7 above.
+  The others are made from BDF font files by 'bdf2font' when building
+  (see the Makefile) and land in lcdFonts.h.
+  - A glyph is stored in the page layout of the LCD: for each page from
+    the top, one byte per column with the top pixel in the MSB. A glyph
+    of a font 'pages' high and 'width' wide takes pages x width bytes.
+  - Proportional fonts have a width for each glyph and keep only the
+    columns of the glyph, the glyphs follow each other in one array.
+  - Fixed fonts (no glyph table) store every glyph at the font width.
+  - The text rows of a font 'pages' high are 'pages' LCD rows apart.
+  - The characters are Unicode code points, the text is UTF-8. Large
+    fonts are read from a font file (see Font Files) as they are used.
+*/
+
+/* Tallest font - in pages of 8 pixel lines */
+#define ST7565_LCD_FONT_MAXPAGES             4
+/* Widest glyph - in columns */
+#define ST7565_LCD_FONT_MAXWIDTH             32
+
+/* Mapped font file - see Font Files */
+typedef struct
+{
+  const uint8_t *map;
+  size_t   size;
+  uint32_t count;   /* Glyphs in the index */
+  unsigned gen;     /* Changes with every file loaded */
+  char     name[32];
+} lcd_font_file_t;
+
+typedef struct
+{
+  uint8_t  width;   /* Columns, including the spacing - 0 if no glyph */
+  uint16_t offset;  /* Of the first byte in the font bitmap */
+} lcd_glyph_t;
+
+typedef struct
+{
+  const char *name;
+  uint8_t  first;   /* Character range */
+  uint8_t  last;
+  uint8_t  pages;   /* Height in LCD pages */
+  uint8_t  width;   /* Fixed width, or the nominal (digit) width */
+  const lcd_glyph_t *glyphs; /* NULL for a fixed font */
+  const uint8_t *bitmap;
+  const lcd_font_file_t *file; /* Glyphs from a font file in place */
+} lcd_font_t;
+
+/* Built in 5x7 font - ASCII, the upper half of the full font is not in
+   Unicode order */
+static const lcd_font_t gs_font_5x7 =
+{
+  "5x7", ST7565_LCD_PARAM_FONT_CHAR_MINVAL,
+  (ST7565_LCD_PARAM_FONT_CHAR_MAXVAL > 0x7F) ? 0x7F :
+    ST7565_LCD_PARAM_FONT_CHAR_MAXVAL,
+  1, ST7565_LCD_PARAM_FONT_CHARWIDTH, NULL, &gca_font[0][0], NULL
+};
+
+/* Fonts converted from BDF - made by 'make' */
+#ifdef __has_include
+#if __has_include("lcdFonts.h")
+#include "lcdFonts.h"
+#endif
+#endif
+#ifndef ST7565_LCD_FONTS_GENERATED
+#define ST7565_LCD_FONTS_GENERATED
+#endif
+
+/* Font file loaded with lcd_font_load - the last font, with no pages
+   till a file is loaded */
+static lcd_font_file_t gs_font_file;
+static lcd_font_t gs_font_loaded =
+{
+  gs_font_file.name, 0, 0, 0, 0, NULL, NULL, &gs_font_file
+};
+
+/* Fonts selectable by number */
+static const lcd_font_t * const gpa_fonts[] =
+{
+  &gs_font_5x7,
+  ST7565_LCD_FONTS_GENERATED
+  &gs_font_loaded
+};
+#define ST7565_LCD_FONTS  (sizeof(gpa_fonts) / sizeof(gpa_fonts[0]))
 
 /************************************************************************/
 /* LCD Format Characters                                                */
@@ -487,8 +692,10 @@ static const uint8_t gca_font[] =
 #define ST7565_LCD_FMT_RAW    ('\x02')
  /**
  * Font Specifier Special Character Followed by 1 Byte of Font Number
- * 
- * - Not Implemented Do not USE
+ *  The Font is used for the text that follows - see @ref lcd_font
+ *
+ *  Eg. "\x0301Small text"
+ *    Prints "Small text" with Font 1
  */
 #define ST7565_LCD_FMT_FONT   ('\x03')
 /**
@@ -513,336 +720,6018 @@ static const uint8_t gca_font[] =
 #define ST7565_LCD_FMT_CURSOR ('\x80')
 
 /************************************************************************/
-/* GPIO Driver Functions                                                */
+/* Shadow Frame Buffer                                                  */
 /************************************************************************/
 
+/* Number of pages kept in the shadow - room for the additional line
+   of panels like the Adafruit LCD, the profile has the pages in use */
+#define ST7565_LCD_FB_ROWS                   ST7565_LCD_PANEL_PAGES
+
+/* Canvas of the portrait orientations - 64 columns of 128 lines */
+#define ST7565_LCD_CANVAS_COLUMNS            ST7565_LCD_PARAM_HEIGHT
+#define ST7565_LCD_CANVAS_ROWS               (ST7565_LCD_MAX_COLUMNS / 8U)
+
 /**
- *  Function to initialize the GPIO and SPI peripheral on Rpi
- *  irrespective of the LCD initialization.
- *  - This is the first function that needs to be called before any other
- *  operation can be performed.
+ * In-memory copy of the display RAM in the same page layout as the
+ *  ST7565: one byte is a column of 8 pixels, one row is one page.
+ *  - The dirty column range of each page is kept as [lo, hi), a page
+ *    with hi == 0 is clean.
+ *  - The write pointer follows the controller column/page address so
+ *    that the data written with @ref lcd_data lands in the right place.
+ *  - In portrait the drawing goes to the Canvas, its modified blocks of
+ *    8 columns are one bit each (see Orientation).
  */
-int init_io()
+typedef struct
+{
+  uint8_t  data[ST7565_LCD_FB_ROWS][ST7565_LCD_MAX_COLUMNS];
+  uint8_t  dirty_lo[ST7565_LCD_FB_ROWS];
+  uint8_t  dirty_hi[ST7565_LCD_FB_ROWS];
+  uint8_t  canvas[ST7565_LCD_CANVAS_ROWS][ST7565_LCD_CANVAS_COLUMNS];
+  uint8_t  canvas_dirty[ST7565_LCD_CANVAS_ROWS];
+  uint16_t row;      /* Write pointer Page */
+  uint16_t column;   /* Write pointer Column */
+  uint8_t  deferred; /* 1 - Hold the writes until @ref lcd_flush */
+} lcd_fb_t;
+
+/************************************************************************/
+/* Driver Statistics                                                    */
+/************************************************************************/
+
+/* Flush latency buckets - bucket k counts [2^k, 2^(k+1)) us, 0 is < 2 */
+#define ST7565_LCD_STATS_BUCKETS             16
+/* Error codes counted - index is the negative code, the lowest code
+   is -142 (Grayscale) */
+#define ST7565_LCD_STATS_ERRORS              160
+
+/**
+ * Counters kept by the driver functions - plain increments only, so
+ *  they can stay on all the time. Shown by 'lcd stats'.
+ */
+typedef struct
+{
+  unsigned long cmd_transfers;  /* lcd_cmd_buf transfers */
+  unsigned long cmd_bytes;
+  unsigned long data_transfers; /* lcd_data_buf transfers */
+  unsigned long data_bytes;
+  unsigned long a0_toggles;     /* A0 level changes */
+  unsigned long gpio_writes;    /* All the pin writes */
+  unsigned long gotos;          /* lcd_goto calls */
+  unsigned long goto_cmds;      /* Addressing commands sent by lcd_goto */
+  unsigned long flushes;        /* lcd_flush calls */
+  unsigned long stream_frames;  /* Frames shown by lcd_stream */
+  unsigned long stream_drops;   /* Frames skipped by lcd_stream */
+  unsigned long glyph_hits;     /* Font file glyphs found in the cache */
+  unsigned long glyph_misses;   /* ... and read from the file */
+  unsigned long plan_segments;  /* Runs sent by the Update Planner */
+  unsigned long plan_ns;        /* ... and their planned bus time */
+  unsigned long gray_frames;    /* Frames shown by the Grayscale thread */
+  unsigned long gray_late;      /* ... and the ones that missed their time */
+  unsigned long flush_us[ST7565_LCD_STATS_BUCKETS];
+  unsigned long errors[ST7565_LCD_STATS_ERRORS];
+} lcd_stats_t;
+
+
+/* Count an error code on its way back to the caller */
+#define ST7565_LCD_ERR(code) \
+  (gp_lcd->stats.errors[(-(code)) % ST7565_LCD_STATS_ERRORS]++, (code))
+
+/************************************************************************/
+/* Transport Interface                                                  */
+/************************************************************************/
+
+/*
+  All the access to the hardware goes through a transport, so the same
+  LCD functions can drive the real LCD or run on a build machine.
+  - pigpio  : The 'pigpio' library (Default build)
+  - spidev  : Linux spidev and GPIO character device ('make spidev')
+  - sim     : Simulated ST7565 in memory, always available ('make sim'
+              builds only this one and needs no hardware libraries)
+  The transport can be picked at run time with the environment variable
+  LCD_TRANSPORT, the first one compiled in is the Default.
+*/
+#if !defined(ST7565_USE_SPIDEV) && !defined(ST7565_USE_SIM)
+#define ST7565_USE_PIGPIO
+#endif
+
+typedef struct
+{
+  const char *name;
+  /* Library / device setup needed before @ref init_io */
+  int  (*init)(void);
+  void (*term)(void);
+  /* Pins and SPI bus used by the LCD - @ref init_io error codes */
+  int  (*open)(void);
+  void (*close)(void);
+  /* Drive a GPIO pin - 0 on success */
+  int  (*pin)(unsigned pin, unsigned level);
+  /* Write out a run of bytes over SPI - 0 on success */
+  int  (*write)(const uint8_t *pData, size_t len);
+  /* Wait for some micro seconds */
+  void (*delay)(unsigned us);
+} lcd_transport_t;
+
+/************************************************************************/
+/* Display Context                                                      */
+/************************************************************************/
+
+/*
+  Everything the driver knows about one LCD is kept in an lcd_t, so
+  more than one Display can be driven - Eg. two panels on CE0 and CE1
+  of the same SPI bus, each with its own A0 and nRST.
+  - The LCD functions work on the current Display of the calling thread
+    (@ref lcd_select), so the single Display API stays as it was.
+  - The current Display is per thread and starts as Display 0, so every
+    thread has to call @ref lcd_select before it uses the LCD functions
+    - Eg. the daemon clients and the async and grayscale threads.
+  - Each thread can work on its own Display, the Displays share no
+    state apart from the library set up by @ref lcd_transport_t init.
+    Two threads must not work on the same Display at the same time.
+*/
+
+/* Number of Displays - One per SPI chip select */
+#define ST7565_LCD_DISPLAYS                  2
+
+/* Display RAM of the Controller - 8 Pages + Icon Page */
+#define ST7565_LCD_SIM_PAGES                 9U
+
+typedef struct
+{
+  uint8_t  ram[ST7565_LCD_SIM_PAGES][ST7565_LCD_RAM_COLUMNS];
+  uint8_t  page;
+  uint8_t  column;
+  uint8_t  start_line;
+  uint8_t  adc_reverse;
+  uint8_t  com_reverse;
+  uint8_t  display_on;
+  uint8_t  disp_reverse;
+  uint8_t  allpts_on;
+  uint8_t  param_cmd;    /* Command waiting for its parameter byte */
+  uint8_t  a0;
+  uint8_t  nrst;
+  /* Wire statistics */
+  unsigned long cmd_bytes;
+  unsigned long data_bytes;
+  unsigned long transfers;
+  unsigned long pin_writes;
+} lcd_sim_t;
+
+/* Ring size in bytes - Power of 2 */
+#define ST7565_LCD_ASYNC_RING                65536U
+typedef struct
+{
+  uint8_t ring[ST7565_LCD_ASYNC_RING] __attribute__((aligned(8)));
+  atomic_size_t head;  /* Producer - end of the queued records */
+  atomic_size_t tail;  /* I/O thread - start of the next record */
+  atomic_int error;    /* Set by the I/O thread on a failed call */
+  sem_t records;       /* Records queued */
+  sem_t fence;         /* Fence records reached */
+  pthread_t thread;
+  const lcd_transport_t *inner; /* Real transport */
+  uint8_t running;
+} lcd_async_t;
+
+/* Grayscale levels - 0 is white, 3 is black */
+#define ST7565_LCD_GRAY_LEVELS               4U
+typedef struct
+{
+  /* Source - bit 0 and bit 1 of the level of each pixel, in the page
+     layout of the LCD */
+  uint8_t lo[ST7565_LCD_MAX_ROWS][ST7565_LCD_MAX_COLUMNS];
+  uint8_t hi[ST7565_LCD_MAX_ROWS][ST7565_LCD_MAX_COLUMNS];
+  pthread_mutex_t lock; /* Source against the timer thread */
+  pthread_t thread;
+  atomic_int stop;      /* Set to end the timer thread */
+  int error;            /* Status of the LCD writes of the thread */
+  unsigned hz;          /* Frames per second */
+  uint8_t running;
+  /* Frames and frame times of the last run */
+  unsigned long frames;
+  unsigned long late;
+  unsigned long busy_ns;
+  unsigned long max_ns;
+} lcd_gray_t;
+
+/* UTF-8 decoder - carried between the bytes of one character */
+typedef struct
+{
+  uint32_t cp;       /* Code point bits so far */
+  uint8_t  need;     /* Continuation bytes still to come */
+} lcd_utf8_t;
+
+typedef struct
+{
+  uint8_t  state;
+  uint8_t  code;     /* Format character being decoded */
+  uint8_t  nargs;    /* Argument bytes needed */
+  uint8_t  have;     /* Argument bytes decoded */
+  uint8_t  args[2];
+  uint8_t  nibble;   /* 1 - High nibble already in 'hi' */
+  uint8_t  hi;
+  uint16_t raw;      /* FMT_RAW data bytes still to come */
+  /* Data of the current text row not yet sent - only within one call,
+     one line for each page of the Font */
+  uint8_t  line[ST7565_LCD_FONT_MAXPAGES][ST7565_LCD_MAX_COLUMNS];
+  size_t   n;
+  uint8_t  last;     /* Width of the last glyph - for Backspace */
+  lcd_utf8_t utf8;
+  int      retcode;
+} lcd_esc_t;
+
+/* Glyph cache of the font file - glyphs kept and hash buckets (power
+   of 2), bounded whatever the size of the font */
+#define ST7565_LCD_GLYPH_SLOTS               64
+#define ST7565_LCD_GLYPH_HASH                128
+#define ST7565_LCD_GLYPH_NONE                0xFF
+
+typedef struct
+{
+  uint32_t cp;
+  uint8_t  width;    /* 0 - the font has no glyph for it */
+  uint8_t  older;    /* LRU list */
+  uint8_t  newer;
+  uint8_t  chain;    /* Next slot in the hash bucket */
+  uint8_t  data[ST7565_LCD_FONT_MAXPAGES * ST7565_LCD_FONT_MAXWIDTH];
+} lcd_glyph_slot_t;
+
+typedef struct
+{
+  lcd_glyph_slot_t slot[ST7565_LCD_GLYPH_SLOTS];
+  uint8_t  bucket[ST7565_LCD_GLYPH_HASH];
+  uint8_t  newest;
+  uint8_t  oldest;
+  uint8_t  used;
+  unsigned gen;      /* Font file the slots are from */
+} lcd_glyph_cache_t;
+
+/* Default bus times of the Update Planner in ns - one byte at the SPI
+   clock, a GPIO write and the transfer setup with its settle delay
+   (the 1 us sleep takes far longer). Measured by lcd_plan_calibrate */
+#define ST7565_LCD_PLAN_BYTE  \
+  ((uint32_t)(8000000000ULL / ST7565_LCD_PARAM_SPISPEED))
+#define ST7565_LCD_PLAN_A0                   1000U
+#define ST7565_LCD_PLAN_TRANSFER             60000U
+
+/**
+ * Bus time of the parts of an update in ns - see Update Planner
+ */
+typedef struct
+{
+  uint32_t cmd_byte;  /* One command byte */
+  uint32_t data_byte; /* One data byte */
+  uint32_t a0;        /* Change of the A0 line */
+  uint32_t transfer;  /* Setup of one SPI transfer */
+} lcd_plan_cost_t;
+
+typedef struct
+{
+  const lcd_transport_t *io; /* Transport in use */
+  uint8_t  io_open;          /* Set once @ref init_io has opened it */
+  /* Wiring */
+  uint8_t  spi_channel;      /* SPI chip select CE0 / CE1 */
+  uint8_t  a0_pin;
+  uint8_t  nrst_pin;
+  /* Transport handles */
+  int      spihandle;        /* pigpio SPI handle */
+  int      spidev_fd;        /* spidev device */
+  int      a0_fd;            /* GPIO line requests for A0 and nRST */
+  int      nrst_fd;
+  /* Position of the Cursor */
+  uint16_t row;
+  uint16_t column;
+  /* Controller state as last programmed by the driver - Used to drop
+     the GPIO writes and commands that would not change anything.
+     Value ST7565_LCD_STATE_UNKNOWN when not known (e.g. after Reset) */
+  uint8_t  a0_level;
+  uint8_t  hw_page;
+  uint8_t  hw_column;
+  uint8_t  contrast;         /* Last set with @ref lcd_bright */
+  /* Panel Profile and its mapping of the text rows (for each Start
+     Line) and columns to the controller pages and columns */
+  const lcd_panel_t *panel;
+  uint8_t  page_lut[ST7565_LCD_MAX_ROWS][ST7565_LCD_FB_ROWS];
+  uint8_t  column_lut[ST7565_LCD_MAX_COLUMNS + 1];
+  /* Orientation - quarter turns and mirror (see Orientation) */
+  uint8_t  rotate;
+  uint8_t  mirror;
+  /* 1 - Powered up and set up by @ref lcd_init since the last Reset or
+     Sleep, so the next one can be a warm start (see Persisted State) */
+  uint8_t  powered;
+  /* Hardware scrolling - the text rows the Display window has been
+     moved by with the Start Line, and if the new Start Line still needs
+     to be sent (it goes out with the next @ref lcd_goto addressing) */
+  uint8_t  scroll;
+  uint8_t  scroll_pending;
+  /* 1 - A new line on the last row scrolls the text up instead of
+     wrapping to the top row */
+  uint8_t  scroll_text;
+  const lcd_font_t *font;    /* Text Font */
+  lcd_fb_t fb;               /* Shadow Frame Buffer */
+  lcd_esc_t esc;             /* Format decoder */
+  lcd_glyph_cache_t glyphs;  /* Glyphs of the font file */
+  lcd_stats_t stats;         /* Driver Statistics */
+  lcd_plan_cost_t cost;      /* Bus times for the Update Planner */
+  lcd_sim_t sim;             /* Simulated Controller */
+  lcd_async_t async;         /* Asynchronous Transport */
+  lcd_gray_t gray;           /* Grayscale (FRC) */
+} lcd_t;
+
+#define ST7565_LCD_STATE_UNKNOWN 0xFF
+
+/* The Displays - defined with the Transport Selection */
+static lcd_t gs_lcd[ST7565_LCD_DISPLAYS];
+/* Current Display of the calling thread */
+static _Thread_local lcd_t *gp_lcd = &gs_lcd[0];
+
+/************************************************************************/
+/* pigpio Transport                                                     */
+/************************************************************************/
+#ifdef ST7565_USE_PIGPIO
+
+static int _lcd_pigpio_init ( void )
+{
+  return (gpioInitialise() < 0) ? -1 : 0;
+}
+static void _lcd_pigpio_term ( void )
+{
+  gpioTerminate();
+}
+static int _lcd_pigpio_open ( void )
 {
-  if(gpioSetMode(LCD_A0, PI_OUTPUT) != 0) return -21;
-  if(gpioSetMode(LCD_nRST, PI_OUTPUT) != 0) return -22;
-  gx_spihandle = spiOpen(0, ST7565_LCD_PARAM_SPISPEED, 192);
-  if(gx_spihandle > 0) /* Other Handles are Open then */
+  /* spiOpen flags - the ux bits 5..7 release the other CE lines from
+     the SPI (1 - not reserved for SPI), the px bits 2..4 are left 0 so
+     the CE of this Display stays active low */
+  const unsigned flags = 0xE0 & ~(0x20U << gp_lcd->spi_channel);
+  unsigned i;
+
+  if(gpioSetMode(gp_lcd->a0_pin, PI_OUTPUT) != 0) return -21;
+  if(gpioSetMode(gp_lcd->nrst_pin, PI_OUTPUT) != 0) return -22;
+  gp_lcd->spihandle = spiOpen(gp_lcd->spi_channel,
+    ST7565_LCD_PARAM_SPISPEED, flags);
+  if(gp_lcd->spihandle > 0) /* Other Handles are Open then */
   {
-    int i;
-    for(i = 0; i < gx_spihandle; i++)
+    int h;
+    /* Leave them alone when another Display holds one */
+    for(i = 0; i < ST7565_LCD_DISPLAYS; i++)
     {
-        spiClose(i);
+      if(&gs_lcd[i] != gp_lcd && gs_lcd[i].spihandle >= 0) break;
+    }
+    if(i == ST7565_LCD_DISPLAYS)
+    {
+      for(h = 0; h < gp_lcd->spihandle; h++)
+      {
+          spiClose(h);
+      }
+      spiClose(gp_lcd->spihandle);
+      /* Since all Handles have been closed */
+      gp_lcd->spihandle = spiOpen(gp_lcd->spi_channel,
+        ST7565_LCD_PARAM_SPISPEED, flags);
     }
-    spiClose(gx_spihandle);
-    /* Since all Handles have been closed */
-    gx_spihandle = spiOpen(0, ST7565_LCD_PARAM_SPISPEED, 192);
   }
-  if(gx_spihandle != 0) /* If Still there is some Issue*/
+  if(gp_lcd->spihandle < 0) /* If Still there is some Issue*/
   {
-    printf("\n ERROR: Invalid SPI handle %d \n", gx_spihandle);
+    printf("\n ERROR: Invalid SPI handle %d \n", gp_lcd->spihandle);
     return -23;
   }
   return 0;
 }
+static void _lcd_pigpio_close ( void )
+{
+  /* Check if the SPI handle is open */
+  if(gp_lcd->spihandle >= 0)
+  {
+    spiClose(gp_lcd->spihandle);
+    gp_lcd->spihandle = -1;
+  }
+}
+static int _lcd_pigpio_pin ( unsigned pin, unsigned level )
+{
+  return gpioWrite(pin, level);
+}
+static int _lcd_pigpio_write ( const uint8_t *pData, size_t len )
+{
+  /* pigpio serialises the transfers of a handle, the Displays on the
+     other chip selects go on in parallel */
+  int ret = spiWrite(gp_lcd->spihandle, (char *)pData, (unsigned)len);
+  return (ret == (int)len) ? 0 : -1;
+}
+static void _lcd_pigpio_delay ( unsigned us )
+{
+  usleep(us);
+}
+
+static const lcd_transport_t gs_io_pigpio =
+{
+  "pigpio",
+  _lcd_pigpio_init, _lcd_pigpio_term,
+  _lcd_pigpio_open, _lcd_pigpio_close,
+  _lcd_pigpio_pin, _lcd_pigpio_write, _lcd_pigpio_delay
+};
+
+#endif /* ST7565_USE_PIGPIO */
 
 /************************************************************************/
-/* LCD Functions                                                        */
+/* Linux spidev Transport                                               */
 /************************************************************************/
 
+/*
+  Build with -DST7565_USE_SPIDEV ('make spidev') to talk to the LCD using
+  the kernel spidev driver and the GPIO character device in place of the
+  'pigpio' library. This needs neither root nor the 'pigpio' machinery,
+  only access to the device nodes (Eg. membership in 'spi' and 'gpio'
+  groups on Raspberry Pi OS).
+
+  - Each write goes out as a single SPI_IOC_MESSAGE ioctl, runs longer
+    than the spidev buffer are split into several transfers.
+  - The A0 line needs to change between the command and data bytes so
+    a command run and a data run can never share one message.
+  - The device paths can be changed at build time to point to a
+    loopback or a fake spidev for testing.
+*/
+#ifdef ST7565_USE_SPIDEV
+
+#ifndef ST7565_LCD_SPIDEV_PATH
+/* printf format - %u is the chip select of the Display */
+#define ST7565_LCD_SPIDEV_PATH               "/dev/spidev0.%u"
+#endif
+#ifndef ST7565_LCD_GPIOCHIP_PATH
+#define ST7565_LCD_GPIOCHIP_PATH             "/dev/gpiochip0"
+#endif
+/* Largest transfer in one SPI_IOC_MESSAGE - Default spidev 'bufsiz' */
+#define ST7565_LCD_SPIDEV_XFER               4096U
+/* Number of transfers a message is allowed to have */
+#define ST7565_LCD_SPIDEV_MAXXFER            8U
+
 /**
- *  Function to send in one byte Command to the LCD
+ *  Function to request one GPIO line as an Output at the given level
  */
-int lcd_cmd(uint8_t byte)
+static int _lcd_spidev_line ( unsigned gpio, unsigned level )
 {
-  char buf[1] = {0};
-  if(gx_spihandle != 0) return -41;
-  buf[0] = (char)byte;
-  if(gpioWrite(LCD_A0, 0) != 0) return -42;
-  if(spiWrite(gx_spihandle, buf, 1) != 1) return -43;
-  usleep(1);
-  return 0;
+  struct gpio_v2_line_request req;
+  int chip;
+
+  chip = open(ST7565_LCD_GPIOCHIP_PATH, O_RDWR | O_CLOEXEC);
+  if (chip < 0) return -1;
+  memset(&req, 0, sizeof(req));
+  req.offsets[0] = gpio;
+  req.num_lines = 1;
+  req.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+  req.config.num_attrs = 1;
+  req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+  req.config.attrs[0].attr.values = level;
+  req.config.attrs[0].mask = 1;
+  strncpy(req.consumer, "lcdST7565", sizeof(req.consumer) - 1);
+  if (ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &req) < 0)
+  {
+    close(chip);
+    return -1;
+  }
+  close(chip);
+  return req.fd;
 }
-/**
- *  Function to Send one byte of graphic data column (8 pixels) to LCD
- */
-int lcd_data(uint8_t byte)
+static int _lcd_spidev_init ( void )
 {
-  char buf[1] = {0};
-  if(gx_spihandle != 0) return -31;
-  buf[0] = (char)byte;
-  if(gpioWrite(LCD_A0, 1) != 0) return -32;
-  if(spiWrite(gx_spihandle, buf, 1) != 1) return -33;
-  usleep(1);
   return 0;
 }
-/**
- *  Function to Reset the LCD to its initial state
- */
-int lcd_reset()
+static void _lcd_spidev_term ( void )
 {
-  if(gpioWrite(LCD_nRST, 0) != 0) return -51;
-  usleep(500000); /* 500 ms*/
-  if(gpioWrite(LCD_nRST, 1) != 0) return -52;
-  return 0;
 }
-/**
- *  Function to control the Contrast and brightness ratio
- *  - This is generally a fixed value for a given LCD.
- */
-int lcd_bright ( int bValue )
+static void _lcd_spidev_close ( void )
 {
-  int retcode = 0;
-  retcode = lcd_cmd(ST7565_LCD_CMD_SET_VOLUME_FIRST);
-  if(retcode != 0) return retcode;
-  return lcd_cmd(ST7565_LCD_CMD_SET_VOLUME_SECOND | (bValue & 0x3f));
+  if (gp_lcd->spidev_fd >= 0) close(gp_lcd->spidev_fd);
+  if (gp_lcd->a0_fd >= 0) close(gp_lcd->a0_fd);
+  if (gp_lcd->nrst_fd >= 0) close(gp_lcd->nrst_fd);
+  gp_lcd->spidev_fd = gp_lcd->a0_fd = gp_lcd->nrst_fd = -1;
 }
-/**
- * @brief Function to position the draw cursor
- *    Need initialization of LCD @ref lcd_init before using this function
- *    This function also updates the cursor location
- *    Thre are special extention to support the normal and
- *    Adafruit specific LCD versions.
- * 
- * @param bColumn The X axis location from the Top Right will be 0
- * @param bRow The Y axis location from the Bottom Left will be 0
- * 
- * @return Status of the operation
- *        0 for successful operation
- *        -61 for Column error
- *        -62 for Row error
- */
-int lcd_goto ( uint8_t bColumn, uint8_t bRow )
+static int _lcd_spidev_open ( void )
 {
-  if (bColumn >= ST7565_LCD_MAX_COLUMNS)
-  {
-    return -61;
-  }
-#ifdef ADAFRUIT_ST7565_LCD  
-  if (bRow >= (ST7565_LCD_MAX_ROWS + 1))
-#else      
-  if (bRow >= (ST7565_LCD_MAX_ROWS))
-#endif      
+  uint8_t mode = SPI_MODE_0, bits = 8;
+  uint32_t speed = ST7565_LCD_PARAM_SPISPEED;
+  char sPath[64];
+
+  gp_lcd->a0_fd = _lcd_spidev_line(gp_lcd->a0_pin, 0);
+  if (gp_lcd->a0_fd < 0) return -21;
+  gp_lcd->nrst_fd = _lcd_spidev_line(gp_lcd->nrst_pin, 1);
+  if (gp_lcd->nrst_fd < 0) return -22;
+  snprintf(sPath, sizeof(sPath), ST7565_LCD_SPIDEV_PATH,
+    (unsigned)gp_lcd->spi_channel);
+  gp_lcd->spidev_fd = open(sPath, O_RDWR | O_CLOEXEC);
+  if (gp_lcd->spidev_fd < 0 ||
+    ioctl(gp_lcd->spidev_fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+    ioctl(gp_lcd->spidev_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+    ioctl(gp_lcd->spidev_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0)
   {
-    return -62;
+    printf("\n ERROR: Could not open %s \n", sPath);
+    return -23;
   }
-
-  /* Get the Values into the Global position storage for the Cursor */
-  gw_row = bRow;
-  gw_column = bColumn;
-
-#ifdef ADAFRUIT_ST7565_LCD
-  /* Set the LCD Row */
-  lcd_cmd(ST7565_LCD_CMD_SET_PAGE | ((7 - (bRow & 0x7)) ^ 4));
-
-  /* Set the LCD Column */
-  ++bColumn; /* 1 Offset for 0th Line */
-  lcd_cmd(ST7565_LCD_CMD_SET_COLUMN_LOWER | (bColumn & 0xf));
-  /* 127 max */
-  lcd_cmd(ST7565_LCD_CMD_SET_COLUMN_UPPER | ((bColumn >> 4) & 0x7)); 
-#else
-  /* Set the LCD Row */
-  lcd_cmd(ST7565_LCD_CMD_SET_PAGE|(7-bRow));
-  
-  /* Set the LCD Column */
-  lcd_cmd(ST7565_LCD_CMD_SET_COLUMN_LOWER | (bColumn & 0xf));
-  /* 127 max */
-  lcd_cmd(ST7565_LCD_CMD_SET_COLUMN_UPPER | ((bColumn >> 4) & 0x7)); 
-#endif    
   return 0;
 }
-/**
- * @brief Function to Clear the Display graphic memory
- *    Need initialization of LCD @ref lcd_init before using this function
- *    This function also updates the cursor location
- * 
- * @param None
- * @return Status of the Operation
- *      0 for successful operation
- *      Else the Status of the @ref lcd_goto in case of error
- */
-int lcd_clear ( void )
+static int _lcd_spidev_pin ( unsigned pin, unsigned level )
 {
-  uint8_t r, c;
-  int retcode = 0;
+  struct gpio_v2_line_values val;
+  int fd = (pin == gp_lcd->a0_pin) ? gp_lcd->a0_fd :
+    (pin == gp_lcd->nrst_pin) ? gp_lcd->nrst_fd : -1;
+  if (fd < 0) return -1;
+  val.mask = 1;
+  val.bits = (level != 0);
+  return (ioctl(fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &val) < 0) ? -1 : 0;
+}
+static int _lcd_spidev_write ( const uint8_t *pData, size_t len )
+{
+  struct spi_ioc_transfer xfer[ST7565_LCD_SPIDEV_MAXXFER];
+  size_t done = 0;
+  unsigned n;
 
-  /* Go through each line of the display */
-#ifdef ADAFRUIT_ST7565_LCD    
-  for (r = 0; r < (ST7565_LCD_MAX_ROWS + 1) ; r++)
-#else
-  for (r = 0; r < ST7565_LCD_MAX_ROWS ; r++)
-#endif
+  if (gp_lcd->spidev_fd < 0) return -1;
+  while (done < len)
   {
-    retcode = lcd_goto(0, r); /* Position cursor */
-    if(retcode != 0) return retcode;
-    /* For each column, write out a blank (white) byte */
-    for (c = 0; c < ST7565_LCD_MAX_COLUMNS ; c++)
+    /* Fill in as many transfers as the message can carry */
+    memset(xfer, 0, sizeof(xfer));
+    for (n = 0; n < ST7565_LCD_SPIDEV_MAXXFER && done < len; n++)
     {
-      lcd_data(0x00);
+      size_t run = len - done;
+      if (run > ST7565_LCD_SPIDEV_XFER) run = ST7565_LCD_SPIDEV_XFER;
+      xfer[n].tx_buf = (uintptr_t)&pData[done];
+      xfer[n].len = (uint32_t)run;
+      xfer[n].speed_hz = ST7565_LCD_PARAM_SPISPEED;
+      xfer[n].bits_per_word = 8;
+      done += run;
     }
+    if (ioctl(gp_lcd->spidev_fd, SPI_IOC_MESSAGE(n), xfer) < 0) return -1;
   }
-  /* Set the Final Address at the Top Left Corner */
-  return lcd_goto(0, 0);  
+  return 0;
+}
+static void _lcd_spidev_delay ( unsigned us )
+{
+  usleep(us);
 }
 
+static const lcd_transport_t gs_io_spidev =
+{
+  "spidev",
+  _lcd_spidev_init, _lcd_spidev_term,
+  _lcd_spidev_open, _lcd_spidev_close,
+  _lcd_spidev_pin, _lcd_spidev_write, _lcd_spidev_delay
+};
+
+#endif /* ST7565_USE_SPIDEV */
+
+/************************************************************************/
+/* Simulated ST7565 Transport                                           */
+/************************************************************************/
+
+/*
+  Emulates the ST7565 controller: the bytes sent with A0 low are decoded
+  as commands and the ones with A0 high land in a 132 x 65 display RAM
+  at the current Page / Column address. Every byte on the wire is counted
+  so the cost of the LCD operations can be measured without a Pi.
+  - Two byte commands (Volume, Booster, Static Indicator) take their
+    parameter from the next command byte.
+  - The display can be saved as PBM with @ref lcd_sim_dump, it shows
+    what the glass would show - COM63 on top, the icon line at the
+    bottom, with Start Line, ADC / COM reverse and the On / Off, Reverse
+    and All Points modes applied.
+*/
+
 /**
- * @brief Function to Initialize the LCD driver with Reset
- * @details Before calling this we need to call @ref init_io
- *      - All previous status would be erased and display is refreshed
- *      - This needs to be done before writing/drawing any thing to the LCD
+ *  Function to bring the Simulated Controller to its Reset state
+ */
+static void _lcd_sim_reset ( void )
+{
+  gp_lcd->sim.page = 0;
+  gp_lcd->sim.column = 0;
+  gp_lcd->sim.start_line = 0;
+  gp_lcd->sim.adc_reverse = 0;
+  gp_lcd->sim.com_reverse = 0;
+  gp_lcd->sim.display_on = 0;
+  gp_lcd->sim.disp_reverse = 0;
+  gp_lcd->sim.allpts_on = 0;
+  gp_lcd->sim.param_cmd = 0;
+}
+/**
+ *  Function to decode one command byte for the Simulated Controller
+ */
+static void _lcd_sim_cmd ( uint8_t byte )
+{
+  if (gp_lcd->sim.param_cmd != 0)
+  {
+    /* Parameter byte of the previous command - nothing to display */
+    gp_lcd->sim.param_cmd = 0;
+    return;
+  }
+  if ((byte & 0xF0) == ST7565_LCD_CMD_SET_PAGE)
+  {
+    if ((byte & 0x0F) < ST7565_LCD_SIM_PAGES) gp_lcd->sim.page = byte & 0x0F;
+  }
+  else if ((byte & 0xF0) == ST7565_LCD_CMD_SET_COLUMN_UPPER)
+  {
+    gp_lcd->sim.column =
+      (uint8_t)(((byte & 0x0F) << 4) | (gp_lcd->sim.column & 0x0F));
+  }
+  else if ((byte & 0xF0) == ST7565_LCD_CMD_SET_COLUMN_LOWER)
+  {
+    gp_lcd->sim.column = (uint8_t)((gp_lcd->sim.column & 0xF0) | (byte & 0x0F));
+  }
+  else if ((byte & 0xC0) == ST7565_LCD_CMD_SET_DISP_START_LINE)
+  {
+    gp_lcd->sim.start_line = byte & 0x3F;
+  }
+  else switch (byte)
+  {
+  case ST7565_LCD_CMD_SET_ADC_NORMAL:    gp_lcd->sim.adc_reverse = 0;  break;
+  case ST7565_LCD_CMD_SET_ADC_REVERSE:   gp_lcd->sim.adc_reverse = 1;  break;
+  case ST7565_LCD_CMD_SET_COM_NORMAL:    gp_lcd->sim.com_reverse = 0;  break;
+  case ST7565_LCD_CMD_SET_COM_REVERSE:   gp_lcd->sim.com_reverse = 1;  break;
+  case ST7565_LCD_CMD_DISPLAY_OFF:       gp_lcd->sim.display_on = 0;   break;
+  case ST7565_LCD_CMD_DISPLAY_ON:        gp_lcd->sim.display_on = 1;   break;
+  case ST7565_LCD_CMD_SET_DISP_NORMAL:   gp_lcd->sim.disp_reverse = 0; break;
+  case ST7565_LCD_CMD_SET_DISP_REVERSE:  gp_lcd->sim.disp_reverse = 1; break;
+  case ST7565_LCD_CMD_SET_ALLPTS_NORMAL: gp_lcd->sim.allpts_on = 0;    break;
+  case ST7565_LCD_CMD_SET_ALLPTS_ON:     gp_lcd->sim.allpts_on = 1;    break;
+  case ST7565_LCD_CMD_INTERNAL_RESET:    _lcd_sim_reset();        break;
+  case ST7565_LCD_CMD_SET_VOLUME_FIRST:
+  case ST7565_LCD_CMD_SET_BOOSTER_FIRST:
+  case ST7565_LCD_CMD_SET_STATIC_ON:
+    gp_lcd->sim.param_cmd = byte;
+    break;
+  default: /* Power, Bias, Resistor ratio, RMW, NOP - no display effect */
+    break;
+  }
+}
+static int _lcd_sim_init ( void )
+{
+  return 0;
+}
+static void _lcd_sim_term ( void )
+{
+}
+static int _lcd_sim_open ( void )
+{
+  memset(&gp_lcd->sim, 0, sizeof(gp_lcd->sim));
+  _lcd_sim_reset();
+  /* Out of Reset, as the real nRST line is opened high */
+  gp_lcd->sim.nrst = 1;
+  return 0;
+}
+static void _lcd_sim_close ( void )
+{
+}
+static int _lcd_sim_pin ( unsigned pin, unsigned level )
+{
+  ++gp_lcd->sim.pin_writes;
+  if (pin == gp_lcd->a0_pin)
+  {
+    gp_lcd->sim.a0 = (level != 0);
+  }
+  else if (pin == gp_lcd->nrst_pin)
+  {
+    if (gp_lcd->sim.nrst && level == 0) _lcd_sim_reset();
+    gp_lcd->sim.nrst = (level != 0);
+  }
+  return 0;
+}
+static int _lcd_sim_write ( const uint8_t *pData, size_t len )
+{
+  size_t i;
+  if (!gp_lcd->sim.nrst) return -1; /* Held in Reset */
+  ++gp_lcd->sim.transfers;
+  if (!gp_lcd->sim.a0)
+  {
+    gp_lcd->sim.cmd_bytes += len;
+    for (i = 0; i < len; i++) _lcd_sim_cmd(pData[i]);
+    return 0;
+  }
+  gp_lcd->sim.data_bytes += len;
+  for (i = 0; i < len; i++)
+  {
+    /* Column address stops at the last RAM column */
+    if (gp_lcd->sim.column < ST7565_LCD_RAM_COLUMNS)
+    {
+      gp_lcd->sim.ram[gp_lcd->sim.page][gp_lcd->sim.column++] = pData[i];
+    }
+  }
+  return 0;
+}
+static void _lcd_sim_delay ( unsigned us )
+{
+  (void)us; /* Simulated time passes instantly */
+}
+
+static const lcd_transport_t gs_io_sim =
+{
+  "sim",
+  _lcd_sim_init, _lcd_sim_term,
+  _lcd_sim_open, _lcd_sim_close,
+  _lcd_sim_pin, _lcd_sim_write, _lcd_sim_delay
+};
+
+/************************************************************************/
+/* Transport Selection                                                  */
+/************************************************************************/
+
+/* Transports compiled in - The first is the Default */
+static const lcd_transport_t * const gpa_transports[] =
+{
+#ifdef ST7565_USE_PIGPIO
+  &gs_io_pigpio,
+#endif
+#ifdef ST7565_USE_SPIDEV
+  &gs_io_spidev,
+#endif
+  &gs_io_sim,
+};
+
+/* The Default Transport, as a constant for the Display table */
+#if defined(ST7565_USE_PIGPIO)
+#define ST7565_LCD_TRANSPORT_DEFAULT         (&gs_io_pigpio)
+#elif defined(ST7565_USE_SPIDEV)
+#define ST7565_LCD_TRANSPORT_DEFAULT         (&gs_io_spidev)
+#else
+#define ST7565_LCD_TRANSPORT_DEFAULT         (&gs_io_sim)
+#endif
+
+/* Display wired to SPI chip select 'ce' with the pins 'a0' and 'nrst' */
+#define ST7565_LCD_DISPLAY(ce, a0, nrst)                              \
+  { .io = ST7565_LCD_TRANSPORT_DEFAULT, .spi_channel = (ce),          \
+    .a0_pin = (a0), .nrst_pin = (nrst),                               \
+    .spihandle = -1, .spidev_fd = -1, .a0_fd = -1, .nrst_fd = -1,     \
+    .a0_level = ST7565_LCD_STATE_UNKNOWN,                             \
+    .hw_page = ST7565_LCD_STATE_UNKNOWN,                              \
+    .hw_column = ST7565_LCD_STATE_UNKNOWN, .font = &gs_font_5x7,     \
+    .panel = ST7565_LCD_PANEL_DEFAULT,                                \
+    .cost = { ST7565_LCD_PLAN_BYTE, ST7565_LCD_PLAN_BYTE,             \
+      ST7565_LCD_PLAN_A0, ST7565_LCD_PLAN_TRANSFER },                 \
+    .gray = { .lock = PTHREAD_MUTEX_INITIALIZER } }
+
+static lcd_t gs_lcd[ST7565_LCD_DISPLAYS] =
+{
+  ST7565_LCD_DISPLAY(0, LCD_A0, LCD_nRST),
+  ST7565_LCD_DISPLAY(1, LCD1_A0, LCD1_nRST),
+};
+
+/**
+ * @brief Function to make a Display the current one of the calling
+ *    thread - All the LCD functions called by it then work on it
+ *    Needed in every thread that uses the LCD functions, a new thread
+ *    starts on Display 0 whatever its creator had selected.
+ * 
+ * @param pLcd Display from @ref lcd_display
+ */
+void lcd_select ( lcd_t *pLcd )
+{
+  gp_lcd = pLcd;
+}
+
+/**
+ * @brief Function to get a Display by its number
+ * 
+ * @param bIndex Display number - 0 on CE0, 1 on CE1
+ * @return The Display or NULL if there is no such Display
+ */
+lcd_t *lcd_display ( unsigned bIndex )
+{
+  return (bIndex < ST7565_LCD_DISPLAYS) ? &gs_lcd[bIndex] : NULL;
+}
+
+/**
+ * @brief Function to select the Transport of the current Display by name
+ *    Needs to be done before the Transport is initialized
+ * 
+ * @param sName Name of the Transport Eg. "pigpio", "spidev", "sim"
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -20 if no such transport is compiled in
+ */
+int lcd_transport_select ( const char *sName )
+{
+  size_t i;
+  for (i = 0; i < sizeof(gpa_transports) / sizeof(gpa_transports[0]); i++)
+  {
+    if (strcmp(gpa_transports[i]->name, sName) == 0)
+    {
+      gp_lcd->io = gpa_transports[i];
+      return 0;
+    }
+  }
+  return ST7565_LCD_ERR(-20);
+}
+
+/************************************************************************/
+/* Asynchronous Transport                                               */
+/************************************************************************/
+
+/*
+  In the asynchronous mode the LCD functions never wait for the SPI.
+  The transport calls (pin, write, delay) are queued as records into a
+  single producer / single consumer ring and an I/O thread plays them
+  on the real transport in the same order.
+  - Only the thread calling the LCD functions may produce.
+  - The ring positions are free running C11 atomics. A record is handed
+    over with a release store of 'head' and given back with a release
+    store of 'tail' - no locks on either side.
+  - A counting semaphore carries the number of records, so the idle
+    I/O thread sleeps. @ref lcd_sync waits for a fence record.
+  - The delays of the LCD functions are done by the I/O thread.
+  - Errors met by the I/O thread are kept and reported by @ref lcd_sync
+  The producer only waits when the ring is full.
+*/
+
+/* Largest write in one record - longer ones are split */
+#define ST7565_LCD_ASYNC_MAXWRITE            4096U
+
+/* Record types */
+#define ST7565_LCD_ASYNC_WRITE               0
+#define ST7565_LCD_ASYNC_PIN                 1
+#define ST7565_LCD_ASYNC_DELAY               2
+#define ST7565_LCD_ASYNC_FENCE               3
+#define ST7565_LCD_ASYNC_STOP                4
+#define ST7565_LCD_ASYNC_SKIP                5 /* Rest of the ring unused */
+
+/* Record header - followed by the data of a write, 8 byte aligned */
+typedef struct
+{
+  uint8_t  op;
+  uint8_t  pin;
+  uint8_t  level;
+  uint8_t  reserved;
+  uint32_t arg; /* Write length or Delay in us */
+} lcd_async_rec_t;
+
+/**
+ *  Function to wait on a semaphore, ignoring the signals
+ */
+static void _lcd_async_wait ( sem_t *pSem )
+{
+  while (sem_wait(pSem) != 0)
+    ;
+}
+/**
+ *  Function to queue one record, waits only if the ring is full
+ */
+static void _lcd_async_put ( uint8_t op, uint8_t pin, uint8_t level, 
+  uint32_t arg, const uint8_t *pData, size_t len )
+{
+  const size_t mask = ST7565_LCD_ASYNC_RING - 1;
+  size_t head = atomic_load_explicit(&gp_lcd->async.head, memory_order_relaxed);
+  size_t need = (sizeof(lcd_async_rec_t) + len + 7) & ~(size_t)7;
+  size_t end = ST7565_LCD_ASYNC_RING - (head & mask);
+  size_t total = need + ((end < need) ? end : 0);
+  lcd_async_rec_t *pRec;
+
+  while (ST7565_LCD_ASYNC_RING - (head - atomic_load_explicit(
+    &gp_lcd->async.tail, memory_order_acquire)) < total)
+  {
+    sched_yield(); /* Ring full - let the I/O thread catch up */
+  }
+  if (end < need)
+  {
+    /* Record does not fit before the end of the ring */
+    pRec = (lcd_async_rec_t *)&gp_lcd->async.ring[head & mask];
+    pRec->op = ST7565_LCD_ASYNC_SKIP;
+    head += end;
+  }
+  pRec = (lcd_async_rec_t *)&gp_lcd->async.ring[head & mask];
+  pRec->op = op;
+  pRec->pin = pin;
+  pRec->level = level;
+  pRec->arg = arg;
+  if (len) memcpy(pRec + 1, pData, len);
+  atomic_store_explicit(&gp_lcd->async.head, head + need, memory_order_release);
+  sem_post(&gp_lcd->async.records);
+}
+/**
+ *  I/O thread - plays the queued records on the real transport
+ *    of the Display given as the argument
+ */
+static void *_lcd_async_thread ( void *pArg )
+{
+  const size_t mask = ST7565_LCD_ASYNC_RING - 1;
+  const lcd_transport_t *io;
+  const lcd_async_rec_t *pRec;
+  size_t tail, size;
+  uint8_t op;
+  int ret;
+
+  /* The real transport works on the Display of its thread */
+  lcd_select((lcd_t *)pArg);
+  io = gp_lcd->async.inner;
+  do
+  {
+    _lcd_async_wait(&gp_lcd->async.records);
+    (void)atomic_load_explicit(&gp_lcd->async.head, memory_order_acquire);
+    tail = atomic_load_explicit(&gp_lcd->async.tail, memory_order_relaxed);
+    pRec = (const lcd_async_rec_t *)&gp_lcd->async.ring[tail & mask];
+    if (pRec->op == ST7565_LCD_ASYNC_SKIP)
+    {
+      tail += ST7565_LCD_ASYNC_RING - (tail & mask);
+      pRec = (const lcd_async_rec_t *)&gp_lcd->async.ring[0];
+    }
+    op = pRec->op;
+    size = sizeof(lcd_async_rec_t);
+    ret = 0;
+    switch (op)
+    {
+    case ST7565_LCD_ASYNC_WRITE:
+      ret = io->write((const uint8_t *)(pRec + 1), pRec->arg);
+      size = (size + pRec->arg + 7) & ~(size_t)7;
+      break;
+    case ST7565_LCD_ASYNC_PIN:
+      ret = io->pin(pRec->pin, pRec->level);
+      break;
+    case ST7565_LCD_ASYNC_DELAY:
+      io->delay(pRec->arg);
+      break;
+    default: /* Fence and Stop */
+      break;
+    }
+    if (ret != 0)
+    {
+      int none = 0;
+      atomic_compare_exchange_strong(&gp_lcd->async.error, &none, ret);
+    }
+    atomic_store_explicit(&gp_lcd->async.tail, tail + size,
+      memory_order_release);
+    if (op == ST7565_LCD_ASYNC_FENCE) sem_post(&gp_lcd->async.fence);
+  } while (op != ST7565_LCD_ASYNC_STOP);
+  return NULL;
+}
+
+static int _lcd_async_init ( void )
+{
+  return gp_lcd->async.inner->init();
+}
+static void _lcd_async_term ( void )
+{
+  gp_lcd->async.inner->term();
+}
+static int _lcd_async_open ( void )
+{
+  return gp_lcd->async.inner->open();
+}
+static void _lcd_async_close ( void )
+{
+  gp_lcd->async.inner->close();
+}
+static int _lcd_async_pin ( unsigned pin, unsigned level )
+{
+  _lcd_async_put(ST7565_LCD_ASYNC_PIN, (uint8_t)pin, (uint8_t)level, 0,
+    NULL, 0);
+  return 0;
+}
+static int _lcd_async_write ( const uint8_t *pData, size_t len )
+{
+  while (len)
+  {
+    size_t n = (len > ST7565_LCD_ASYNC_MAXWRITE) ? 
+      ST7565_LCD_ASYNC_MAXWRITE : len;
+    _lcd_async_put(ST7565_LCD_ASYNC_WRITE, 0, 0, (uint32_t)n, pData, n);
+    pData += n;
+    len -= n;
+  }
+  return 0;
+}
+static void _lcd_async_delay ( unsigned us )
+{
+  _lcd_async_put(ST7565_LCD_ASYNC_DELAY, 0, 0, us, NULL, 0);
+}
+
+static const lcd_transport_t gs_io_async =
+{
+  "async",
+  _lcd_async_init,
+  _lcd_async_term,
+  _lcd_async_open,
+  _lcd_async_close,
+  _lcd_async_pin,
+  _lcd_async_write,
+  _lcd_async_delay,
+};
+
+/**
+ * @brief Function to wait till everything queued in the asynchronous
+ *    mode has reached the LCD. Returns at once if not in this mode.
+ * 
+ * @param None
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -102 if a transport call of the I/O thread has failed since
+ *        the last sync
+ */
+int lcd_sync ( void )
+{
+  if (!gp_lcd->async.running) return 0;
+  _lcd_async_put(ST7565_LCD_ASYNC_FENCE, 0, 0, 0, NULL, 0);
+  _lcd_async_wait(&gp_lcd->async.fence);
+  return (atomic_exchange(&gp_lcd->async.error, 0) != 0) ? 
+    ST7565_LCD_ERR(-102) : 0;
+}
+/**
+ * @brief Function to switch the asynchronous mode on or off
+ *    Needs @ref init_io first, @ref close_io switches it off.
+ *    Once on, the LCD functions return as soon as their transfers are
+ *    queued and their errors are only seen through @ref lcd_sync.
+ * 
+ * @param bEnable 1 - Queue the transfers for the I/O thread
+ *                0 - Wait for the queue to drain and write directly
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -101 if the I/O thread could not be started
+ *        Else the Status of @ref lcd_sync when switching off
+ */
+int lcd_async ( uint8_t bEnable )
+{
+  int retcode;
+  if (bEnable)
+  {
+    if (gp_lcd->async.running) return 0;
+    if (!gp_lcd->io_open) return -101;
+    atomic_init(&gp_lcd->async.head, 0);
+    atomic_init(&gp_lcd->async.tail, 0);
+    atomic_init(&gp_lcd->async.error, 0);
+    gp_lcd->async.inner = gp_lcd->io;
+    if (sem_init(&gp_lcd->async.records, 0, 0) != 0) return -101;
+    sem_init(&gp_lcd->async.fence, 0, 0);
+    if (pthread_create(&gp_lcd->async.thread, NULL, _lcd_async_thread,
+      gp_lcd))
+    {
+      sem_destroy(&gp_lcd->async.records);
+      sem_destroy(&gp_lcd->async.fence);
+      return -101;
+    }
+    gp_lcd->io = &gs_io_async;
+    gp_lcd->async.running = 1;
+    return 0;
+  }
+  if (!gp_lcd->async.running) return 0;
+  retcode = lcd_sync();
+  _lcd_async_put(ST7565_LCD_ASYNC_STOP, 0, 0, 0, NULL, 0);
+  pthread_join(gp_lcd->async.thread, NULL);
+  sem_destroy(&gp_lcd->async.records);
+  sem_destroy(&gp_lcd->async.fence);
+  gp_lcd->io = gp_lcd->async.inner;
+  gp_lcd->async.running = 0;
+  return retcode;
+}
+
+/************************************************************************/
+/* Simulated LCD Image                                                  */
+/************************************************************************/
+
+/**
+ * @brief Function to save what the Simulated LCD shows as a PBM image
+ *    The wire statistics are added as a comment in the header.
+ * 
+ * @param sPath File to write
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -81 if the Simulated transport is not in use
+ *        -82 for error in writing the file
+ */
+int lcd_sim_dump ( const char *sPath )
+{
+  uint8_t row[(ST7565_LCD_RAM_COLUMNS + 7) / 8];
+  unsigned y, x, line, col;
+  int on;
+  FILE *f;
+
+  /* Let the queued transfers reach the Simulated LCD first */
+  lcd_sync();
+  if ((gp_lcd->async.running ? gp_lcd->async.inner : gp_lcd->io) != &gs_io_sim) 
+    return -81;
+  f = fopen(sPath, "wb");
+  if (f == NULL) return -82;
+  fprintf(f, "P4\n# transfers=%lu cmd=%lu data=%lu pins=%lu\n%u %u\n",
+    gp_lcd->sim.transfers, gp_lcd->sim.cmd_bytes, gp_lcd->sim.data_bytes,
+    gp_lcd->sim.pin_writes, ST7565_LCD_RAM_COLUMNS,
+    ST7565_LCD_SIM_PAGES * 8 - 7);
+  for (y = 0; y <= ST7565_LCD_PARAM_HEIGHT; y++)
+  {
+    memset(row, 0, sizeof(row));
+    for (x = 0; x < ST7565_LCD_RAM_COLUMNS; x++)
+    {
+      col = gp_lcd->sim.adc_reverse ? (ST7565_LCD_RAM_COLUMNS - 1 - x) : x;
+      if (y == ST7565_LCD_PARAM_HEIGHT)
+      {
+        /* Icon line is not affected by the Start Line */
+        on = gp_lcd->sim.ram[ST7565_LCD_SIM_PAGES - 1][col] & 0x01;
+      }
+      else
+      {
+        /* COM63 is the top of the glass */
+        line = ST7565_LCD_PARAM_HEIGHT - 1 - y;
+        if (gp_lcd->sim.com_reverse) line = ST7565_LCD_PARAM_HEIGHT - 1 - line;
+        line = (line + gp_lcd->sim.start_line) % ST7565_LCD_PARAM_HEIGHT;
+        on = (gp_lcd->sim.ram[line / 8][col] >> (line % 8)) & 0x01;
+      }
+      if (gp_lcd->sim.disp_reverse) on = !on;
+      if (gp_lcd->sim.allpts_on) on = 1;
+      if (!gp_lcd->sim.display_on) on = 0;
+      if (on) row[x / 8] |= (uint8_t)(0x80 >> (x % 8));
+    }
+    fwrite(row, 1, sizeof(row), f);
+  }
+  return (fclose(f) == 0) ? 0 : -82;
+}
+
+/************************************************************************/
+/* Orientation                                                          */
+/************************************************************************/
+
+/*
+  The picture can be turned by 90, 180 or 270 degrees and mirrored left
+  to right as it is seen - set with the Panel Profile ('rotate' and
+  'mirror') or at run time with @ref lcd_orient.
+  - 180 degrees and the mirror cost nothing: the controller reverses its
+    columns (ADC) and its lines (COM), only the visible columns move to
+    the other end of the controller RAM. The picture turns as a whole,
+    so the pages of the panel must be in the order of the lines (like
+    'generic'), a panel like the Adafruit one needs a profile of its own
+    with adc / com reverse and the page_map for it.
+  - 90 and 270 degrees (portrait, 64 x 128) need the pixels moved. The
+    drawing functions work on a Canvas in the page layout of the
+    portrait picture and @ref lcd_flush turns only its modified blocks
+    of 8 x 8 pixels into the Shadow with a bit transpose - a Canvas line
+    is a Shadow column, a Canvas column a Shadow line. 270 degrees is 90
+    degrees and the 180 degrees of the controller, so both cost the same.
+  - Text at the Cursor (lcd_puts, lcd_data) and frames (lcd_frame,
+    streams, animations) are in the layout of the LCD, not turned.
+*/
+
+/* Quarter turns of the portrait orientations are odd */
+#define ST7565_LCD_PORTRAIT                  (gp_lcd->rotate & 1U)
+
+/**
+ *  Function to transpose an 8 x 8 pixel block - pRow[0..7] are the rows
+ *  (MSB is the left pixel), pCol[0..7] get the columns (MSB is the top
+ *  pixel). The block is held in a 64 bit word and transposed with three
+ *  delta swaps (Hacker's Delight 7-3), it is its own inverse.
+ */
+static inline void _lcd_transpose8 ( const uint8_t *pRow, uint8_t *pCol )
+{
+  uint64_t x = 0, t;
+  int i;
+  for (i = 0; i < 8; i++) x = (x << 8) | pRow[i];
+  t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+  x = x ^ t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+  x = x ^ t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+  x = x ^ t ^ (t << 28);
+  for (i = 7; i >= 0; i--, x >>= 8) pCol[i] = (uint8_t)x;
+}
+/**
+ *  Function to check that a panel can show an orientation - the Canvas
+ *  needs all the 128 x 64 pixels
+ */
+static int _lcd_orient_fits ( const lcd_panel_t *pPanel, unsigned rotate )
+{
+  return !(rotate & 1U) || (pPanel->columns == ST7565_LCD_MAX_COLUMNS && 
+    pPanel->pages >= ST7565_LCD_MAX_ROWS);
+}
+/**
+ *  Function to get the reverse the orientation adds to the one of the
+ *  Panel Profile - bit 0 for the ADC, bit 1 for the COM
+ */
+static unsigned _lcd_orient_flip ( void )
+{
+  unsigned flip = (gp_lcd->rotate >= 2) ? 3U : 0U;
+  /* Left to right as seen are the lines of the LCD in portrait */
+  if (gp_lcd->mirror) flip ^= ST7565_LCD_PORTRAIT ? 2U : 1U;
+  return flip;
+}
+/**
+ *  Function to rebuild the Canvas from the Shadow - Shadow column
+ *  127 - y is Canvas line y
+ */
+static void _lcd_canvas_load ( void )
+{
+  uint8_t col[8];
+  unsigned r, g, i, base;
+
+  for (r = 0; r < ST7565_LCD_CANVAS_ROWS; r++)
+  {
+    base = ST7565_LCD_MAX_COLUMNS - 8 * (r + 1);
+    for (g = 0; g < ST7565_LCD_MAX_ROWS; g++)
+    {
+      for (i = 0; i < 8; i++) col[i] = gp_lcd->fb.data[g][base + 7 - i];
+      _lcd_transpose8(col, &gp_lcd->fb.canvas[r][g * 8]);
+    }
+    gp_lcd->fb.canvas_dirty[r] = 0;
+  }
+}
+/**
+ *  Function to take the orientation of the current Display - the column
+ *  lookup table, and the Canvas for portrait
+ */
+static void _lcd_orient_use ( void )
+{
+  const lcd_panel_t *pPanel = gp_lcd->panel;
+  unsigned c, offset = pPanel->offset;
+
+  /* Reversed columns start from the other end of the RAM */
+  if (_lcd_orient_flip() & 1U)
+  {
+    offset = ST7565_LCD_RAM_COLUMNS - pPanel->offset - pPanel->columns;
+  }
+  /* One past the last column is where a full row of data ends */
+  for (c = 0; c <= ST7565_LCD_MAX_COLUMNS; c++)
+  {
+    gp_lcd->column_lut[c] = (c + offset < ST7565_LCD_RAM_COLUMNS) ?
+      (uint8_t)(c + offset) : ST7565_LCD_STATE_UNKNOWN;
+  }
+  gp_lcd->hw_column = ST7565_LCD_STATE_UNKNOWN;
+  if (ST7565_LCD_PORTRAIT) _lcd_canvas_load();
+}
+
+/************************************************************************/
+/* Panel Selection                                                      */
+/************************************************************************/
+
+/* Profiles read from the file */
+static lcd_panel_t gs_panels[ST7565_LCD_PANEL_FILE_MAX];
+static unsigned gs_panel_count;
+/* Profile of each Display named in the file, empty for the Default */
+static char gs_panel_of[ST7565_LCD_DISPLAYS][ST7565_LCD_PANEL_NAME];
+/* The file is read once - its status is kept for the later calls */
+static uint8_t gs_panels_read;
+static int gs_panels_status;
+
+/**
+ *  Function to take one 'key = value' of a profile
+ * 
+ * @return 0 if taken, -1 for an unknown key or a bad value
+ */
+static int _lcd_panel_value ( lcd_panel_t *pPanel, const char *sKey,
+  char *sValue )
+{
+  char *pEnd;
+  unsigned long v = strtoul(sValue, &pEnd, 0);
+  int num = (pEnd != sValue && *pEnd == '\0');
+
+  if (strcmp(sKey, "page_map") == 0)
+  {
+    unsigned i;
+    for (i = 0; i < ST7565_LCD_PANEL_PAGES && *sValue != '\0'; i++)
+    {
+      v = strtoul(sValue, &pEnd, 0);
+      if (pEnd == sValue || v >= ST7565_LCD_PANEL_PAGES) return -1;
+      pPanel->page_map[i] = (uint8_t)v;
+      for (sValue = pEnd; *sValue == ' ' || *sValue == '\t'; sValue++);
+    }
+    return (*sValue == '\0') ? 0 : -1;
+  }
+  if (strcmp(sKey, "adc") == 0 || strcmp(sKey, "com") == 0)
+  {
+    uint8_t *pReverse = (sKey[0] == 'a') ? 
+      &pPanel->adc_reverse : &pPanel->com_reverse;
+    if (strcmp(sValue, "normal") == 0) *pReverse = 0;
+    else if (strcmp(sValue, "reverse") == 0) *pReverse = 1;
+    else return -1;
+    return 0;
+  }
+  if (strcmp(sKey, "mirror") == 0)
+  {
+    if (strcmp(sValue, "off") == 0) pPanel->mirror = 0;
+    else if (strcmp(sValue, "on") == 0) pPanel->mirror = 1;
+    else return -1;
+    return 0;
+  }
+  if (!num) return -1;
+  if (strcmp(sKey, "columns") == 0 && v >= 1 && v <= ST7565_LCD_MAX_COLUMNS)
+    pPanel->columns = (uint8_t)v;
+  else if (strcmp(sKey, "pages") == 0 && v >= 1 && 
+    v <= ST7565_LCD_PANEL_PAGES)
+    pPanel->pages = (uint8_t)v;
+  else if (strcmp(sKey, "offset") == 0 && v < ST7565_LCD_RAM_COLUMNS)
+    pPanel->offset = (uint8_t)v;
+  else if (strcmp(sKey, "bias") == 0 && (v == 7 || v == 9))
+    pPanel->bias = (uint8_t)v;
+  else if (strcmp(sKey, "contrast") == 0 && v <= 0x3F)
+    pPanel->contrast = (uint8_t)v;
+  else if (strcmp(sKey, "ratio") == 0 && v <= 7)
+    pPanel->ratio = (uint8_t)v;
+  else if (strcmp(sKey, "rotate") == 0 && v % 90 == 0 && v <= 270)
+    pPanel->rotate = (uint8_t)(v / 90);
+  else return -1;
+  return 0;
+}
+/**
+ *  Function to read the profiles file - Once, a missing file is fine
+ * 
+ * @return 0 for success, -131 if it can not be read, -132 for a bad line
+ */
+static int _lcd_panel_read ( void )
+{
+  const char *sPath = getenv("LCD_PANELS");
+  char line[256], *pKey, *pValue, *p;
+  lcd_panel_t *pPanel = NULL;
+  FILE *pFile;
+  unsigned i;
+
+  if (gs_panels_read) return gs_panels_status;
+  gs_panels_read = 1;
+  if (sPath == NULL) sPath = ST7565_LCD_PARAM_PANELS;
+  pFile = fopen(sPath, "r");
+  if (pFile == NULL) return gs_panels_status = (errno == ENOENT) ? 0 : -131;
+
+  while (gs_panels_status == 0 && fgets(line, sizeof(line), pFile) != NULL)
+  {
+    /* Comment and the blanks around */
+    if ((p = strchr(line, '#')) != NULL) *p = '\0';
+    for (pKey = line; *pKey == ' ' || *pKey == '\t'; pKey++);
+    for (p = pKey + strlen(pKey); p > pKey && (unsigned char)p[-1] <= ' '; )
+      *--p = '\0';
+    if (*pKey == '\0') continue;
+
+    if (*pKey == '[')
+    {
+      /* New profile - starts as the generic one */
+      p = strchr(pKey, ']');
+      if (p == NULL || p[1] != '\0' || p - pKey - 1 < 1 || 
+        p - pKey - 1 >= ST7565_LCD_PANEL_NAME || 
+        gs_panel_count >= ST7565_LCD_PANEL_FILE_MAX)
+      {
+        gs_panels_status = -132;
+        break;
+      }
+      pPanel = &gs_panels[gs_panel_count++];
+      *pPanel = gca_panels[0];
+      memset(pPanel->name, 0, sizeof(pPanel->name));
+      memcpy(pPanel->name, pKey + 1, (size_t)(p - pKey - 1));
+      continue;
+    }
+
+    /* key = value */
+    pValue = strchr(pKey, '=');
+    if (pValue == NULL)
+    {
+      gs_panels_status = -132;
+      break;
+    }
+    for (p = pValue; p > pKey && (p[-1] == ' ' || p[-1] == '\t'); p--);
+    *p = '\0';
+    for (++pValue; *pValue == ' ' || *pValue == '\t'; pValue++);
+    if (pPanel != NULL)
+    {
+      if (_lcd_panel_value(pPanel, pKey, pValue) != 0)
+        gs_panels_status = -132;
+    }
+    else if (strncmp(pKey, "display", 7) == 0 && pKey[7] >= '0' &&
+      pKey[7] < '0' + ST7565_LCD_DISPLAYS && pKey[8] == '\0' &&
+      strlen(pValue) < ST7565_LCD_PANEL_NAME)
+    {
+      strcpy(gs_panel_of[pKey[7] - '0'], pValue);
+    }
+    else gs_panels_status = -132;
+  }
+  fclose(pFile);
+
+  /* The visible columns must be in the controller RAM, and the panel
+     large enough for its orientation */
+  for (i = 0; gs_panels_status == 0 && i < gs_panel_count; i++)
+  {
+    if (gs_panels[i].offset + gs_panels[i].columns > ST7565_LCD_RAM_COLUMNS ||
+      !_lcd_orient_fits(&gs_panels[i], gs_panels[i].rotate))
+      gs_panels_status = -132;
+  }
+  if (gs_panels_status != 0) gs_panel_count = 0;
+  return gs_panels_status;
+}
+/**
+ *  Function to find a profile by name - the file ones first, so they
+ *  can replace the built-in ones
+ */
+static const lcd_panel_t *_lcd_panel_find ( const char *sName )
+{
+  unsigned i;
+  for (i = 0; i < gs_panel_count; i++)
+  {
+    if (strcmp(gs_panels[i].name, sName) == 0) return &gs_panels[i];
+  }
+  for (i = 0; i < sizeof(gca_panels) / sizeof(gca_panels[0]); i++)
+  {
+    if (strcmp(gca_panels[i].name, sName) == 0) return &gca_panels[i];
+  }
+  return NULL;
+}
+/**
+ *  Function to make a profile the one of the current Display, with the
+ *  lookup tables of its page and column mapping and its orientation
+ */
+static void _lcd_panel_use ( const lcd_panel_t *pPanel )
+{
+  unsigned s, r;
+
+  gp_lcd->panel = pPanel;
+  gp_lcd->contrast = pPanel->contrast;
+  gp_lcd->rotate = pPanel->rotate;
+  gp_lcd->mirror = pPanel->mirror;
+  /* Only the text rows move with the Start Line, not the Icon page */
+  for (s = 0; s < ST7565_LCD_MAX_ROWS; s++)
+  {
+    for (r = 0; r < ST7565_LCD_FB_ROWS; r++)
+    {
+      gp_lcd->page_lut[s][r] = pPanel->page_map[(r < ST7565_LCD_MAX_ROWS) ?
+        ((r + s) & ST7565_LCD_MASK_ROWS) : r];
+    }
+  }
+  gp_lcd->hw_page = ST7565_LCD_STATE_UNKNOWN;
+  _lcd_orient_use();
+}
+/**
+ *  Function to pick the profile of the current Display as it is opened -
+ *  LCD_PANEL, else the file, else the one it has
+ */
+static int _lcd_panel_open ( void )
+{
+  const lcd_panel_t *pPanel = gp_lcd->panel;
+  const char *sName = getenv("LCD_PANEL");
+  int retcode = _lcd_panel_read();
+
+  if (retcode != 0) return retcode;
+  if (sName == NULL || sName[0] == '\0') sName = gs_panel_of[gp_lcd - gs_lcd];
+  if (sName[0] != '\0')
+  {
+    pPanel = _lcd_panel_find(sName);
+    if (pPanel == NULL) return -133;
+  }
+  _lcd_panel_use(pPanel);
+  return 0;
+}
+/**
+ * @brief Function to change the Panel Profile of the current Display
+ *    Use @ref lcd_init after, to send its setup
+ * 
+ * @param sName Built-in profile or one of the profiles file
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -131 if the profiles file can not be read
+ *        -132 for a bad line in the profiles file
+ *        -133 if there is no such profile
+ */
+int lcd_panel ( const char *sName )
+{
+  const lcd_panel_t *pPanel;
+  int retcode = _lcd_panel_read();
+  if (retcode != 0) return ST7565_LCD_ERR(retcode);
+  pPanel = _lcd_panel_find(sName);
+  if (pPanel == NULL) return ST7565_LCD_ERR(-133);
+  _lcd_panel_use(pPanel);
+  return 0;
+}
+/**
+ *  Function to get the setup commands of the profile - Bias, ADC, COM
+ *  (with the reverse of the orientation) and Resistor ratio
+ */
+static void _lcd_panel_setup ( uint8_t *pSetup )
+{
+  const lcd_panel_t *pPanel = gp_lcd->panel;
+  unsigned flip = _lcd_orient_flip();
+  pSetup[0] = (pPanel->bias == 9) ? 
+    ST7565_LCD_CMD_SET_BIAS_9 : ST7565_LCD_CMD_SET_BIAS_7;
+  pSetup[1] = (pPanel->adc_reverse ^ (flip & 1U)) ? 
+    ST7565_LCD_CMD_SET_ADC_REVERSE : ST7565_LCD_CMD_SET_ADC_NORMAL;
+  pSetup[2] = (pPanel->com_reverse ^ (flip >> 1)) ? 
+    ST7565_LCD_CMD_SET_COM_REVERSE : ST7565_LCD_CMD_SET_COM_NORMAL;
+  pSetup[3] = ST7565_LCD_CMD_SET_RESISTOR_RATIO | (pPanel->ratio & 0x7);
+}
+
+/************************************************************************/
+/* Persisted State                                                      */
+/************************************************************************/
+
+/*
+  A restarted program (or the next 'lcd' command) finds the LCD still
+  powered and set up, with the screen it was left with. To avoid the
+  600 ms Reset and power up of @ref lcd_init each Display saves its
+  state when it is closed and reads it back when it is opened:
+  - The file is ST7565_LCD_PARAM_STATE (or the environment variable
+    LCD_STATE, empty for none) with '.N' for Display N.
+  - It holds the boot it was made in, the transport, Panel Profile and
+    wiring, the setup sent to the controller, whether it was powered,
+    the orientation and the Shadow - an orientation set at run time is
+    kept as long as the profile has the same one.
+  - Only a state of the same boot, transport, profile, wiring and setup
+    that was powered is taken: @ref lcd_init then sends the setup again
+    and the saved screen instead of the Reset and power up sequence.
+  - The Simulated LCD is gone with the process, so it has no state.
+*/
+
+/* Kernel identity of the current boot */
+#define ST7565_LCD_STATE_BOOTID  "/proc/sys/kernel/random/boot_id"
+#define ST7565_LCD_STATE_MAGIC               "L7S2"
+
+/* Panel setup sent by lcd_init - Bias, ADC, COM, Resistor ratio */
+#define ST7565_LCD_STATE_SETUP               4
+
+/* State file - only bytes, so there is no padding */
+typedef struct
+{
+  char     magic[4];
+  char     boot_id[40];
+  char     transport[16];
+  char     panel[ST7565_LCD_PANEL_NAME];
+  uint8_t  spi_channel;
+  uint8_t  a0_pin;
+  uint8_t  nrst_pin;
+  uint8_t  orient;   /* Orientation of the profile - rotate | mirror << 2 */
+  uint8_t  powered;
+  uint8_t  contrast;
+  uint8_t  rotate;   /* Orientation in use */
+  uint8_t  mirror;
+  uint8_t  setup[ST7565_LCD_STATE_SETUP];
+  uint8_t  data[ST7565_LCD_FB_ROWS][ST7565_LCD_MAX_COLUMNS];
+  uint8_t  dirty_lo[ST7565_LCD_FB_ROWS];
+  uint8_t  dirty_hi[ST7565_LCD_FB_ROWS];
+} lcd_state_t;
+
+/**
+ *  Function to get the State file of the current Display
+ * 
+ * @return 1 if the Display keeps a State, else 0
+ */
+static int _lcd_state_path ( char *sPath, size_t size )
+{
+  const char *sBase = getenv("LCD_STATE");
+  if (sBase == NULL) sBase = ST7565_LCD_PARAM_STATE;
+  if (sBase[0] == '\0' || gp_lcd->io == &gs_io_sim) return 0;
+  snprintf(sPath, size, "%s.%d", sBase, (int)(gp_lcd - gs_lcd));
+  return 1;
+}
+/**
+ *  Function to fill in a State for the current Display
+ */
+static void _lcd_state_fill ( lcd_state_t *pState )
+{
+  int fd;
+  ssize_t n = 0;
+
+  memset(pState, 0, sizeof(*pState));
+  memcpy(pState->magic, ST7565_LCD_STATE_MAGIC, 4);
+  fd = open(ST7565_LCD_STATE_BOOTID, O_RDONLY | O_CLOEXEC);
+  if (fd >= 0)
+  {
+    n = read(fd, pState->boot_id, sizeof(pState->boot_id) - 1);
+    close(fd);
+  }
+  /* Without the boot the state can not be trusted */
+  if (n <= 0) pState->magic[0] = '\0';
+  strncpy(pState->transport, gp_lcd->io->name, sizeof(pState->transport) - 1);
+  memcpy(pState->panel, gp_lcd->panel->name, sizeof(pState->panel));
+  pState->spi_channel = gp_lcd->spi_channel;
+  pState->a0_pin = gp_lcd->a0_pin;
+  pState->nrst_pin = gp_lcd->nrst_pin;
+  pState->orient = (uint8_t)(gp_lcd->panel->rotate | 
+    (gp_lcd->panel->mirror << 2));
+  pState->powered = gp_lcd->powered;
+  pState->contrast = gp_lcd->contrast;
+  pState->rotate = gp_lcd->rotate;
+  pState->mirror = gp_lcd->mirror;
+  _lcd_panel_setup(pState->setup);
+}
+/**
+ *  Function to take over the saved State of the Display as it is opened
+ *  - If it matches, the Display is known to be powered and the Shadow
+ *    has the screen
+ */
+static void _lcd_state_load ( void )
+{
+  lcd_state_t now, saved;
+  char sPath[PATH_MAX];
+  ssize_t n;
+  int fd;
+
+  gp_lcd->powered = 0;
+  if (!_lcd_state_path(sPath, sizeof(sPath))) return;
+  fd = open(sPath, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;
+  n = read(fd, &saved, sizeof(saved));
+  close(fd);
+  _lcd_state_fill(&now);
+  /* Everything up to the state itself must be the same */
+  if (n != (ssize_t)sizeof(saved) || now.magic[0] == '\0' || 
+    memcmp(&now, &saved, offsetof(lcd_state_t, powered)) != 0 ||
+    !saved.powered || saved.rotate > 3 || 
+    !_lcd_orient_fits(gp_lcd->panel, saved.rotate)) return;
+  /* The orientation changed at run time, then the setup for it */
+  gp_lcd->rotate = saved.rotate;
+  gp_lcd->mirror = (saved.mirror != 0);
+  _lcd_panel_setup(now.setup);
+  if (memcmp(now.setup, saved.setup, sizeof(now.setup)) != 0)
+  {
+    gp_lcd->rotate = gp_lcd->panel->rotate;
+    gp_lcd->mirror = gp_lcd->panel->mirror;
+    return;
+  }
+  gp_lcd->powered = 1;
+  gp_lcd->contrast = saved.contrast;
+  memcpy(gp_lcd->fb.data, saved.data, sizeof(saved.data));
+  memcpy(gp_lcd->fb.dirty_lo, saved.dirty_lo, sizeof(saved.dirty_lo));
+  memcpy(gp_lcd->fb.dirty_hi, saved.dirty_hi, sizeof(saved.dirty_hi));
+  _lcd_orient_use();
+}
+/**
+ *  Function to save the State of the Display as it is closed - Written
+ *  to a new file that then replaces the old one
+ */
+static void _lcd_state_save ( void )
+{
+  lcd_state_t state;
+  char sPath[PATH_MAX], sNew[PATH_MAX + 4];
+  int fd, ok;
+
+  if (!_lcd_state_path(sPath, sizeof(sPath))) return;
+  _lcd_state_fill(&state);
+  memcpy(state.data, gp_lcd->fb.data, sizeof(state.data));
+  /* What is not flushed yet is not on the LCD */
+  memcpy(state.dirty_lo, gp_lcd->fb.dirty_lo, sizeof(state.dirty_lo));
+  memcpy(state.dirty_hi, gp_lcd->fb.dirty_hi, sizeof(state.dirty_hi));
+  snprintf(sNew, sizeof(sNew), "%s.new", sPath);
+  fd = open(sNew, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return;
+  ok = (write(fd, &state, sizeof(state)) == (ssize_t)sizeof(state));
+  close(fd);
+  if (!ok || rename(sNew, sPath) != 0) unlink(sNew);
+}
+
+/************************************************************************/
+/* GPIO Driver Functions                                                */
+/************************************************************************/
+
+/**
+ *  Function to initialize the GPIO and SPI peripheral on Rpi
+ *  irrespective of the LCD initialization.
+ *  - This is the first function that needs to be called before any other
+ *  operation can be performed.
+ */
+int init_io()
+{
+  int retcode = _lcd_panel_open();
+  if (retcode != 0) return ST7565_LCD_ERR(retcode);
+  retcode = gp_lcd->io->open();
+  gp_lcd->io_open = (retcode == 0);
+  if (gp_lcd->io_open) _lcd_state_load();
+  return (retcode < 0) ? ST7565_LCD_ERR(retcode) : retcode;
+}
+/**
+ *  Function to end the Grayscale timer thread of the current Display
+ *  (see Grayscale)
+ * 
+ * @return Status of the LCD writes of the thread
+ */
+static int _lcd_gray_halt ( void )
+{
+  if (!gp_lcd->gray.running) return 0;
+  atomic_store(&gp_lcd->gray.stop, 1);
+  pthread_join(gp_lcd->gray.thread, NULL);
+  gp_lcd->gray.running = 0;
+  return gp_lcd->gray.error;
+}
+/**
+ *  Function to release the GPIO and SPI peripheral
+ */
+void close_io()
+{
+  _lcd_gray_halt();
+  lcd_async(0); /* Everything queued goes out first */
+  if (gp_lcd->io_open)
+  {
+    _lcd_state_save();
+    gp_lcd->io->close();
+    gp_lcd->io_open = 0;
+  }
+}
+
+/************************************************************************/
+/* Font Files                                                           */
+/************************************************************************/
+
+/*
+  Fonts too large to build in (Eg. GNU Unifont with most of Unicode) are
+  made into a font file with 'bdf2font -o' and loaded at run time with
+  @ref lcd_font_load. All numbers are little endian.
+
+  Header (16 bytes):
+    "L7F1"       Magic
+    uint32_t     Glyph count
+    uint8_t      Pages (height)
+    uint8_t      Nominal width
+    uint8_t      reserved[6]
+  Index, a record of 8 bytes for each glyph in code point order:
+    uint32_t     Code point (bits 0 - 23) and width (bits 24 - 31)
+    uint32_t     File offset of the glyph, pages x width bytes
+
+  The file is mapped, so only the index pages searched and the glyphs
+  used are ever read in and the kernel can drop them again. Each Display
+  keeps the glyphs it draws in a small LRU cache: a hash of the code
+  point finds a glyph in the cache, a miss is a binary search of the
+  index and a copy of the glyph over the least recently used one. The
+  code points the font has no glyph for are cached the same way.
+*/
+
+#define ST7565_LCD_FONTFILE_MAGIC            "L7F1"
+#define ST7565_LCD_FONTFILE_HEADER           16
+#define ST7565_LCD_FONTFILE_RECORD           8
+
+/**
+ *  Function to feed one byte to the UTF-8 decoder
+ *
+ * @return 1 with the code point in *pCp once a character is complete
+ *        0 while more bytes are needed
+ *        -1 for a byte which can not start a character
+ *        A sequence broken by a byte that does not continue it is
+ *        dropped and the byte decoded on its own.
+ */
+static inline int _lcd_utf8 ( lcd_utf8_t *pDec, uint8_t c, uint32_t *pCp )
+{
+  if (pDec->need != 0)
+  {
+    if ((c & 0xC0) == 0x80)
+    {
+      pDec->cp = (pDec->cp << 6) | (c & 0x3FU);
+      if (--pDec->need != 0) return 0;
+      *pCp = pDec->cp;
+      return 1;
+    }
+    pDec->need = 0;
+  }
+  if (c < 0x80)
+  {
+    *pCp = c;
+    return 1;
+  }
+  /* Lead bytes - C0 / C1 and above F4 would only give overlong or out
+     of range code points */
+  if (c >= 0xC2 && c <= 0xDF) { pDec->cp = c & 0x1FU; pDec->need = 1; }
+  else if (c >= 0xE0 && c <= 0xEF) { pDec->cp = c & 0x0FU; pDec->need = 2; }
+  else if (c >= 0xF0 && c <= 0xF4) { pDec->cp = c & 0x07U; pDec->need = 3; }
+  else return -1;
+  return 0;
+}
+/**
+ *  Function to read a 32 bit little endian number of the font file
+ */
+static inline uint32_t _lcd_fontfile_get ( const uint8_t *p )
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+    ((uint32_t)p[3] << 24);
+}
+/**
+ *  Function to copy the glyph of a code point out of the font file
+ *
+ * @return Width of the glyph, 0 if the font has none
+ */
+static uint8_t _lcd_fontfile_read ( uint32_t cp, uint8_t *pData )
+{
+  const uint8_t *pIndex = gs_font_file.map + ST7565_LCD_FONTFILE_HEADER;
+  const size_t pages = gs_font_loaded.pages;
+  uint32_t lo = 0, hi = gs_font_file.count, mid, rec, offset;
+  uint8_t width;
+
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo) / 2;
+    rec = _lcd_fontfile_get(&pIndex[(size_t)mid * ST7565_LCD_FONTFILE_RECORD]);
+    if ((rec & 0xFFFFFFU) == cp)
+    {
+      width = (uint8_t)(rec >> 24);
+      offset = _lcd_fontfile_get(
+        &pIndex[(size_t)mid * ST7565_LCD_FONTFILE_RECORD + 4]);
+      /* The file is not trusted */
+      if (width == 0 || width > ST7565_LCD_FONT_MAXWIDTH ||
+        offset > gs_font_file.size ||
+        gs_font_file.size - offset < pages * width) return 0;
+      memcpy(pData, &gs_font_file.map[offset], pages * width);
+      return width;
+    }
+    if ((rec & 0xFFFFFFU) < cp) lo = mid + 1;
+    else hi = mid;
+  }
+  return 0;
+}
+/**
+ *  Function to get a glyph of the font file through the glyph cache of
+ *  the current Display
+ *
+ * @return First byte of the glyph, NULL if the font has none
+ */
+static const uint8_t *_lcd_glyph_cache ( uint32_t cp, uint8_t *pWidth )
+{
+  lcd_glyph_cache_t *pCache = &gp_lcd->glyphs;
+  const unsigned h = (cp ^ (cp >> 7)) & (ST7565_LCD_GLYPH_HASH - 1);
+  lcd_glyph_slot_t *pSlot;
+  uint8_t i, *pLink;
+
+  if (pCache->gen != gs_font_file.gen)
+  {
+    /* Another font file - start empty */
+    memset(pCache->bucket, ST7565_LCD_GLYPH_NONE, sizeof(pCache->bucket));
+    pCache->newest = pCache->oldest = ST7565_LCD_GLYPH_NONE;
+    pCache->used = 0;
+    pCache->gen = gs_font_file.gen;
+  }
+  for (i = pCache->bucket[h]; i != ST7565_LCD_GLYPH_NONE;
+    i = pCache->slot[i].chain)
+  {
+    if (pCache->slot[i].cp == cp) break;
+  }
+  if (i != ST7565_LCD_GLYPH_NONE)
+  {
+    ++gp_lcd->stats.glyph_hits;
+    if (i == pCache->newest) goto found;
+    /* Take it out of the LRU list */
+    pSlot = &pCache->slot[i];
+    pCache->slot[pSlot->newer].older = pSlot->older;
+    if (pSlot->older != ST7565_LCD_GLYPH_NONE)
+      pCache->slot[pSlot->older].newer = pSlot->newer;
+    else
+      pCache->oldest = pSlot->newer;
+  }
+  else
+  {
+    ++gp_lcd->stats.glyph_misses;
+    if (pCache->used < ST7565_LCD_GLYPH_SLOTS)
+    {
+      i = pCache->used++;
+    }
+    else
+    {
+      /* Reuse the least recently used slot */
+      i = pCache->oldest;
+      pSlot = &pCache->slot[i];
+      pCache->oldest = pSlot->newer;
+      pCache->slot[pCache->oldest].older = ST7565_LCD_GLYPH_NONE;
+      pLink = &pCache->bucket[(pSlot->cp ^ (pSlot->cp >> 7)) &
+        (ST7565_LCD_GLYPH_HASH - 1)];
+      while (*pLink != i) pLink = &pCache->slot[*pLink].chain;
+      *pLink = pSlot->chain;
+    }
+    pSlot = &pCache->slot[i];
+    pSlot->cp = cp;
+    pSlot->width = _lcd_fontfile_read(cp, pSlot->data);
+    pSlot->chain = pCache->bucket[h];
+    pCache->bucket[h] = i;
+  }
+  /* Most recently used */
+  pSlot = &pCache->slot[i];
+  pSlot->older = pCache->newest;
+  pSlot->newer = ST7565_LCD_GLYPH_NONE;
+  if (pCache->newest != ST7565_LCD_GLYPH_NONE)
+    pCache->slot[pCache->newest].newer = i;
+  else
+    pCache->oldest = i;
+  pCache->newest = i;
+found:
+  if (pCache->slot[i].width == 0) return NULL;
+  *pWidth = pCache->slot[i].width;
+  return pCache->slot[i].data;
+}
+/**
+ *  Function to find the glyph of a character in a font
+ *
+ * @return First byte of the glyph, NULL if the font has none
+ */
+static inline const uint8_t *_lcd_font_glyph ( const lcd_font_t *pFont,
+  uint32_t cp, uint8_t *pWidth )
+{
+  const lcd_glyph_t *pGlyph;
+  if (pFont->file != NULL) return _lcd_glyph_cache(cp, pWidth);
+  if (cp < pFont->first || cp > pFont->last) return NULL;
+  if (pFont->glyphs == NULL)
+  {
+    *pWidth = pFont->width;
+    return &pFont->bitmap[(size_t)(cp - pFont->first) * pFont->width *
+      pFont->pages];
+  }
+  pGlyph = &pFont->glyphs[cp - pFont->first];
+  if (pGlyph->width == 0) return NULL;
+  *pWidth = pGlyph->width;
+  return &pFont->bitmap[pGlyph->offset];
+}
+/**
+ * @brief Function to load a font file made by 'bdf2font -o'
+ *    It becomes the last font (see @ref lcd_font) of all the Displays.
+ *    A font file loaded before is replaced, this must not be done while
+ *    another thread draws text.
+ * 
+ * @param sPath Font file
+ * @return Font number for @ref lcd_font or the error code
+ *        -35 if the file can not be read
+ *        -36 if it is not a valid font file
+ */
+int lcd_font_load ( const char *sPath )
+{
+  const uint8_t *pMap;
+  const char *sName;
+  struct stat st;
+  uint32_t count;
+  int fd;
+
+  fd = open(sPath, O_RDONLY);
+  if (fd < 0) return ST7565_LCD_ERR(-35);
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return ST7565_LCD_ERR(-35);
+  }
+  if (st.st_size < ST7565_LCD_FONTFILE_HEADER)
+  {
+    close(fd);
+    return ST7565_LCD_ERR(-36);
+  }
+  pMap = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (pMap == MAP_FAILED) return ST7565_LCD_ERR(-35);
+  count = _lcd_fontfile_get(&pMap[4]);
+  if (memcmp(pMap, ST7565_LCD_FONTFILE_MAGIC, 4) != 0 || pMap[8] == 0 ||
+    pMap[8] > ST7565_LCD_FONT_MAXPAGES || pMap[9] == 0 ||
+    pMap[9] > ST7565_LCD_FONT_MAXWIDTH ||
+    count > ((size_t)st.st_size - ST7565_LCD_FONTFILE_HEADER) /
+      ST7565_LCD_FONTFILE_RECORD)
+  {
+    munmap((void *)pMap, (size_t)st.st_size);
+    return ST7565_LCD_ERR(-36);
+  }
+  /* Glyphs are looked up at random */
+  madvise((void *)pMap, (size_t)st.st_size, MADV_RANDOM);
+
+  if (gs_font_file.map != NULL)
+  {
+    munmap((void *)gs_font_file.map, gs_font_file.size);
+  }
+  gs_font_file.map = pMap;
+  gs_font_file.size = (size_t)st.st_size;
+  gs_font_file.count = count;
+  ++gs_font_file.gen;
+  sName = strrchr(sPath, '/');
+  snprintf(gs_font_file.name, sizeof(gs_font_file.name), "%s",
+    (sName != NULL) ? sName + 1 : sPath);
+  gs_font_loaded.pages = pMap[8];
+  gs_font_loaded.width = pMap[9];
+  return (int)ST7565_LCD_FONTS - 1;
+}
+
+/************************************************************************/
+/* LCD Functions                                                        */
+/************************************************************************/
+
+/**
+ *  Function to mark the columns [bLo, bHi) of a page in the Shadow
+ *  as modified
+ */
+static void _lcd_fb_mark ( uint8_t bLo, uint8_t bHi, uint8_t bRow )
+{
+  if (gp_lcd->fb.dirty_hi[bRow] == 0)
+  {
+    gp_lcd->fb.dirty_lo[bRow] = bLo;
+    gp_lcd->fb.dirty_hi[bRow] = bHi;
+    return;
+  }
+  if (bLo < gp_lcd->fb.dirty_lo[bRow])
+    gp_lcd->fb.dirty_lo[bRow] = bLo;
+  if (bHi > gp_lcd->fb.dirty_hi[bRow])
+    gp_lcd->fb.dirty_hi[bRow] = bHi;
+}
+/**
+ *  Function to store data at the Shadow write pointer and advance it
+ *  the same way the controller auto increments its column address
+ *  
+ * @param pData The graphic data columns
+ * @param len Number of bytes
+ * @param bMark 1 to record the change as dirty, 0 if already on Display
+ */
+static void _lcd_fb_store ( const uint8_t *pData, size_t len, 
+  uint8_t bMark )
+{
+  size_t n = 0;
+  if (gp_lcd->fb.row < ST7565_LCD_FB_ROWS && 
+    gp_lcd->fb.column < ST7565_LCD_MAX_COLUMNS)
+  {
+    uint8_t *p = &gp_lcd->fb.data[gp_lcd->fb.row][gp_lcd->fb.column];
+    size_t i;
+    n = ST7565_LCD_MAX_COLUMNS - gp_lcd->fb.column;
+    if (n > len) n = len;
+    if (!bMark)
+    {
+      memcpy(p, pData, n);
+    }
+    else for (i = 0; i < n; i++)
+    {
+      if (p[i] != pData[i])
+      {
+        p[i] = pData[i];
+        _lcd_fb_mark((uint8_t)(gp_lcd->fb.column + i), 
+          (uint8_t)(gp_lcd->fb.column + i + 1), (uint8_t)gp_lcd->fb.row);
+      }
+    }
+  }
+  gp_lcd->fb.column += len;
+}
+
+/**
+ *  Function to drive a control pin of the LCD
+ */
+static int _lcd_pin ( unsigned pin, unsigned level )
+{
+  ++gp_lcd->stats.gpio_writes;
+  return gp_lcd->io->pin(pin, level);
+}
+/**
+ *  Function to drive the A0 line only if its level needs to change
+ */
+static int _lcd_a0 ( uint8_t bLevel )
+{
+  if (gp_lcd->a0_level == bLevel) return 0;
+  ++gp_lcd->stats.a0_toggles;
+  if (_lcd_pin(gp_lcd->a0_pin, bLevel) != 0)
+  {
+    gp_lcd->a0_level = ST7565_LCD_STATE_UNKNOWN;
+    return -1;
+  }
+  gp_lcd->a0_level = bLevel;
+  return 0;
+}
+/**
+ *  Function to forget the Controller state after a Reset
+ */
+static void _lcd_state_invalidate ( void )
+{
+  gp_lcd->a0_level = ST7565_LCD_STATE_UNKNOWN;
+  gp_lcd->hw_page = ST7565_LCD_STATE_UNKNOWN;
+  gp_lcd->hw_column = ST7565_LCD_STATE_UNKNOWN;
+  gp_lcd->scroll = 0; /* Start Line is back at 0 */
+  gp_lcd->scroll_pending = 0;
+}
+/**
+ *  Function to get the Controller page showing a text row - follows the
+ *  hardware scrolling and the page order of the Panel Profile
+ */
+static uint8_t _lcd_page ( uint8_t bRow )
+{
+  return gp_lcd->page_lut[gp_lcd->scroll][bRow];
+}
+
+/**
+ *  Function to send in a sequence of Commands to the LCD in a single
+ *  SPI transfer - The A0 line is set only once for the complete sequence
+ */
+int lcd_cmd_buf(const uint8_t *pCmd, size_t len)
+{
+  if(len == 0) return 0;
+  if(!gp_lcd->io_open) return ST7565_LCD_ERR(-41);
+  if(_lcd_a0(0) != 0) return ST7565_LCD_ERR(-42);
+  ++gp_lcd->stats.cmd_transfers;
+  gp_lcd->stats.cmd_bytes += len;
+  if(gp_lcd->io->write(pCmd, len) != 0) return ST7565_LCD_ERR(-43);
+  gp_lcd->io->delay(1);
+  return 0;
+}
+/**
+ *  Function to send in one byte Command to the LCD
+ */
+int lcd_cmd(uint8_t byte)
+{
+  return lcd_cmd_buf(&byte, 1);
+}
+/**
+ *  Function to Send a run of graphic data columns to the LCD in a single
+ *  SPI transfer - The A0 line is set only once for the complete run
+ *  - The controller auto increments the column address for each byte
+ *    so a run should not cross the end of the page.
+ */
+int lcd_data_buf(const uint8_t *pData, size_t len)
+{
+  if(len == 0) return 0;
+  if(gp_lcd->fb.deferred)
+  {
+    /* Only compose into the Shadow - sent out later by lcd_flush */
+    _lcd_fb_store(pData, len, 1);
+    return 0;
+  }
+  if(!gp_lcd->io_open) return ST7565_LCD_ERR(-31);
+  if(_lcd_a0(1) != 0) return ST7565_LCD_ERR(-32);
+  ++gp_lcd->stats.data_transfers;
+  gp_lcd->stats.data_bytes += len;
+  if(gp_lcd->io->write(pData, len) != 0)
+  {
+    gp_lcd->hw_column = ST7565_LCD_STATE_UNKNOWN;
+    return ST7565_LCD_ERR(-33);
+  }
+  gp_lcd->io->delay(1);
+  /* Column address auto increments - stops at the last RAM column */
+  if (gp_lcd->hw_column != ST7565_LCD_STATE_UNKNOWN)
+  {
+    gp_lcd->hw_column = (gp_lcd->hw_column + len < ST7565_LCD_RAM_COLUMNS) ?
+      (uint8_t)(gp_lcd->hw_column + len) : ST7565_LCD_STATE_UNKNOWN;
+  }
+  /* Keep the Shadow in line with what is on the Display */
+  _lcd_fb_store(pData, len, 0);
+  return 0;
+}
+/**
+ *  Function to Send one byte of graphic data column (8 pixels) to LCD
+ */
+int lcd_data(uint8_t byte)
+{
+  return lcd_data_buf(&byte, 1);
+}
+/**
+ *  Function to Reset the LCD to its initial state
+ */
+int lcd_reset()
+{
+  _lcd_state_invalidate();
+  gp_lcd->powered = 0;
+  if(_lcd_pin(gp_lcd->nrst_pin, 0) != 0) return ST7565_LCD_ERR(-51);
+  gp_lcd->io->delay(500000); /* 500 ms*/
+  if(_lcd_pin(gp_lcd->nrst_pin, 1) != 0) return ST7565_LCD_ERR(-52);
+  return 0;
+}
+/**
+ *  Function to control the Contrast and brightness ratio
+ *  - This is generally a fixed value for a given LCD.
+ */
+int lcd_bright ( int bValue )
+{
+  int retcode = 0;
+  retcode = lcd_cmd(ST7565_LCD_CMD_SET_VOLUME_FIRST);
+  if(retcode != 0) return retcode;
+  retcode = lcd_cmd(ST7565_LCD_CMD_SET_VOLUME_SECOND | (bValue & 0x3f));
+  if(retcode == 0) gp_lcd->contrast = (uint8_t)(bValue & 0x3f);
+  return retcode;
+}
+/**
+ * @brief Function to position the draw cursor
+ *    Need initialization of LCD @ref lcd_init before using this function
+ *    This function also updates the cursor location
+ *    The normal and Adafruit specific LCD versions (and others) are
+ *    supported through the Panel Profile lookup tables.
+ * 
+ * @param bColumn The X axis location from the Top Right will be 0
+ * @param bRow The Y axis location from the Bottom Left will be 0
+ * 
+ * @return Status of the operation
+ *        0 for successful operation
+ *        -61 for Column error
+ *        -62 for Row error
+ *        Else the Status of @ref lcd_cmd_buf for the addressing
+ */
+int lcd_goto ( uint8_t bColumn, uint8_t bRow )
+{
+  uint8_t page;
+  uint8_t cmd[4];
+  size_t n = 0;
+  int retcode;
+  ++gp_lcd->stats.gotos;
+  if (bColumn >= gp_lcd->panel->columns)
+  {
+    return ST7565_LCD_ERR(-61);
+  }
+  if (bRow >= gp_lcd->panel->pages)
+  {
+    return ST7565_LCD_ERR(-62);
+  }
+
+  /* Get the Values into the Global position storage for the Cursor */
+  gp_lcd->row = bRow;
+  gp_lcd->column = bColumn;
+
+  /* Shadow write pointer follows the controller address */
+  gp_lcd->fb.row = bRow;
+  gp_lcd->fb.column = bColumn;
+  if (gp_lcd->fb.deferred)
+  {
+    return 0; /* Addressing is done by lcd_flush */
+  }
+
+  page = _lcd_page(bRow);
+  bColumn = gp_lcd->column_lut[bColumn];
+
+  /* Move the Display window first if scrolled */
+  if (gp_lcd->scroll_pending)
+  {
+    cmd[n++] = ST7565_LCD_CMD_SET_DISP_START_LINE | 
+      ((ST7565_LCD_PARAM_HEIGHT - gp_lcd->scroll * ST7565_LCD_PARAM_PAGEHEIGHT)
+        & 0x3F);
+  }
+
+  /* Set the LCD Row - unless the Controller is already there */
+  if (gp_lcd->hw_page != page)
+  {
+    cmd[n++] = ST7565_LCD_CMD_SET_PAGE | page;
+  }
+
+  /* Set the LCD Column - only the nibbles that differ */
+  if (gp_lcd->hw_column != bColumn)
+  {
+    uint8_t known = (gp_lcd->hw_column != ST7565_LCD_STATE_UNKNOWN);
+    if (!known || ((gp_lcd->hw_column ^ bColumn) & 0x0F))
+    {
+      cmd[n++] = ST7565_LCD_CMD_SET_COLUMN_LOWER | (bColumn & 0xf);
+    }
+    if (!known || ((gp_lcd->hw_column ^ bColumn) & 0xF0))
+    {
+      /* The whole nibble - a profile offset reaches RAM column 131 */
+      cmd[n++] = ST7565_LCD_CMD_SET_COLUMN_UPPER | ((bColumn >> 4) & 0x0F);
+    }
+  }
+
+  /* All the addressing goes out in one transfer */
+  gp_lcd->stats.goto_cmds += n;
+  retcode = lcd_cmd_buf(cmd, n);
+  if (retcode == 0)
+  {
+    gp_lcd->hw_page = page;
+    gp_lcd->hw_column = bColumn;
+    gp_lcd->scroll_pending = 0;
+  }
+  else
+  {
+    gp_lcd->hw_page = ST7565_LCD_STATE_UNKNOWN;
+    gp_lcd->hw_column = ST7565_LCD_STATE_UNKNOWN;
+  }
+  return retcode;
+}
+/**
+ * @brief Function to Clear the Display graphic memory
+ *    Need initialization of LCD @ref lcd_init before using this function
+ *    This function also updates the cursor location
+ * 
+ * @param None
+ * @return Status of the Operation
+ *      0 for successful operation
+ *      Else the Status of the @ref lcd_goto in case of error
+ */
+int lcd_clear ( void )
+{
+  static const uint8_t blank[ST7565_LCD_MAX_COLUMNS] = {0};
+  uint8_t r;
+  int retcode = 0;
+
+  /* Go through each line of the display */
+  for (r = 0; r < gp_lcd->panel->pages ; r++)
+  {
+    retcode = lcd_goto(0, r); /* Position cursor */
+    if(retcode != 0) return retcode;
+    /* Write out a complete page of blank (white) bytes */
+    lcd_data_buf(blank, gp_lcd->panel->columns);
+  }
+  if (ST7565_LCD_PORTRAIT) _lcd_canvas_load();
+  /* Set the Final Address at the Top Left Corner */
+  return lcd_goto(0, 0);  
+}
+
+/**
+ * @brief Function to select where the drawing operations go
+ *    In the deferred mode @ref lcd_data and @ref lcd_goto only work on
+ *    the Shadow Frame Buffer and nothing is sent to the LCD until
+ *    @ref lcd_flush is called. This helps to compose a complete frame
+ *    and push only what has changed.
+ * 
+ * @param bDeferred 0 - Write through to the LCD (Default)
+ *                  1 - Compose in the Shadow Frame Buffer
+ */
+void lcd_fb_deferred ( uint8_t bDeferred )
+{
+  uint16_t row = gp_lcd->row, column = gp_lcd->column;
+  if (gp_lcd->fb.deferred && !bDeferred)
+  {
+    /* Bring the Controller address back to the write pointer */
+    gp_lcd->fb.deferred = 0;
+    if (gp_lcd->fb.row < ST7565_LCD_FB_ROWS && 
+      gp_lcd->fb.column < ST7565_LCD_MAX_COLUMNS)
+    {
+      lcd_goto((uint8_t)gp_lcd->fb.column, (uint8_t)gp_lcd->fb.row);
+      gp_lcd->row = row;
+      gp_lcd->column = column;
+    }
+  }
+  gp_lcd->fb.deferred = (bDeferred != 0);
+}
+/**
+ * @brief Function to write a run of graphic data into the Shadow
+ *    Frame Buffer without sending it to the LCD
+ * 
+ * @param bColumn Starting Column
+ * @param bRow Page to write
+ * @param pData Graphic data columns
+ * @param len Number of bytes, clipped at the right edge
+ * 
+ * @return Status of the operation
+ *        0 for successful operation
+ *        -61 for Column error
+ *        -62 for Row error
+ */
+int lcd_fb_write ( uint8_t bColumn, uint8_t bRow, const uint8_t *pData,
+  size_t len )
+{
+  size_t i;
+  if (bColumn >= ST7565_LCD_MAX_COLUMNS) return ST7565_LCD_ERR(-61);
+  if (bRow >= gp_lcd->panel->pages) return ST7565_LCD_ERR(-62);
+  if (len > (size_t)(ST7565_LCD_MAX_COLUMNS - bColumn))
+  {
+    len = ST7565_LCD_MAX_COLUMNS - bColumn;
+  }
+  for (i = 0; i < len; i++, bColumn++)
+  {
+    if (gp_lcd->fb.data[bRow][bColumn] != pData[i])
+    {
+      gp_lcd->fb.data[bRow][bColumn] = pData[i];
+      _lcd_fb_mark(bColumn, bColumn + 1, bRow);
+    }
+  }
+  return 0;
+}
+/**
+ * @brief Function to mark the complete Shadow Frame Buffer as modified
+ *    Used when the LCD contents are not known, the next @ref lcd_flush
+ *    would then send out all the pages.
+ * 
+ * @param None
+ */
+void lcd_fb_invalidate ( void )
+{
+  uint8_t r;
+  for (r = 0; r < gp_lcd->panel->pages; r++)
+  {
+    gp_lcd->fb.dirty_lo[r] = 0;
+    gp_lcd->fb.dirty_hi[r] = ST7565_LCD_MAX_COLUMNS;
+  }
+}
+/**
+ *  Function to turn the modified blocks of the Canvas into the Shadow
+ *  (see Orientation) - Canvas line y is Shadow column 127 - y
+ */
+static void _lcd_canvas_store ( void )
+{
+  uint8_t col[8], *pDst;
+  unsigned r, g, i, base, first, last, blocks;
+
+  for (r = 0; r < ST7565_LCD_CANVAS_ROWS; r++)
+  {
+    blocks = gp_lcd->fb.canvas_dirty[r];
+    if (blocks == 0) continue;
+    gp_lcd->fb.canvas_dirty[r] = 0;
+    base = ST7565_LCD_MAX_COLUMNS - 8 * (r + 1);
+    for (g = 0; g < ST7565_LCD_MAX_ROWS; g++)
+    {
+      if (!(blocks & (1U << g))) continue;
+      _lcd_transpose8(&gp_lcd->fb.canvas[r][g * 8], col);
+      pDst = &gp_lcd->fb.data[g][base];
+      first = 8;
+      last = 0;
+      for (i = 0; i < 8; i++)
+      {
+        if (pDst[i] == col[7 - i]) continue;
+        pDst[i] = col[7 - i];
+        if (first == 8) first = i;
+        last = i + 1;
+      }
+      if (first < last)
+      {
+        _lcd_fb_mark((uint8_t)(base + first), (uint8_t)(base + last), 
+          (uint8_t)g);
+      }
+    }
+  }
+}
+/**
+ * @brief Function to send the modified parts of the Shadow Frame Buffer
+ *    Need initialization of LCD @ref lcd_init before using this function
+ *    For every page only the dirty column span is addressed and sent.
+ *    In portrait the drawing on the Canvas is turned into the Shadow
+ *    first. The cursor location is preserved.
+ * 
+ * @param None
+ * @return Status of the Operation
+ *      0 for successful operation
+ *      Else the Status of the @ref lcd_goto or @ref lcd_data in case
+ *      of error, the failed page remains dirty
+ */
+int lcd_flush ( void )
+{
+  uint8_t r, lo, hi;
+  int retcode = 0;
+  uint8_t deferred = gp_lcd->fb.deferred;
+  uint16_t row = gp_lcd->row, column = gp_lcd->column;
+  uint16_t fbrow = gp_lcd->fb.row, fbcolumn = gp_lcd->fb.column;
+  struct timespec t0, t1;
+  unsigned long us;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  if (ST7565_LCD_PORTRAIT) _lcd_canvas_store();
+  gp_lcd->fb.deferred = 0;
+  for (r = 0; r < gp_lcd->panel->pages && retcode == 0; r++)
+  {
+    if (gp_lcd->fb.dirty_hi[r] == 0) continue;
+    lo = gp_lcd->fb.dirty_lo[r];
+    hi = gp_lcd->fb.dirty_hi[r];
+    gp_lcd->fb.dirty_hi[r] = 0;
+    retcode = lcd_goto(lo, r);
+    if (retcode == 0)
+    {
+      retcode = lcd_data_buf(&gp_lcd->fb.data[r][lo], hi - lo);
+    }
+    if (retcode != 0) /* Retry this page on the next flush */
+    {
+      gp_lcd->fb.dirty_lo[r] = lo;
+      gp_lcd->fb.dirty_hi[r] = hi;
+    }
+  }
+  /* Restore the Cursor and the Controller address */
+  if (!deferred && fbrow < ST7565_LCD_FB_ROWS && 
+    fbcolumn < ST7565_LCD_MAX_COLUMNS)
+  {
+    lcd_goto((uint8_t)fbcolumn, (uint8_t)fbrow);
+  }
+  gp_lcd->row = row;
+  gp_lcd->column = column;
+  gp_lcd->fb.row = fbrow;
+  gp_lcd->fb.column = fbcolumn;
+  gp_lcd->fb.deferred = deferred;
+
+  /* Flush latency in the log2 buckets */
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  us = (unsigned long)((t1.tv_sec - t0.tv_sec) * 1000000L + 
+    (t1.tv_nsec - t0.tv_nsec) / 1000);
+  ++gp_lcd->stats.flushes;
+  for (r = 0; (us >> 1) != 0 && r < ST7565_LCD_STATS_BUCKETS - 1; r++)
+  {
+    us >>= 1;
+  }
+  ++gp_lcd->stats.flush_us[r];
+  return retcode;
+}
+/**
+ *  Thread flushing one Display for @ref lcd_flush_all
+ */
+static void *_lcd_flush_thread ( void *pArg )
+{
+  lcd_select((lcd_t *)pArg);
+  return (void *)(intptr_t)lcd_flush();
+}
+/**
+ * @brief Function to flush all the open Displays at the same time
+ *    Each Display other than the current one is flushed by a thread of
+ *    its own, so the Displays are sent out in parallel. The Displays
+ *    share the SPI bus, the overlap is in the preparation and on the
+ *    A0 / nRST lines while the bus transfers take turns.
+ * 
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        The first error of the Displays
+ */
+int lcd_flush_all ( void )
+{
+  pthread_t thread[ST7565_LCD_DISPLAYS];
+  uint8_t started[ST7565_LCD_DISPLAYS];
+  lcd_t *pSelf = gp_lcd;
+  void *pRet;
+  int retcode = 0, ret;
+  unsigned i;
+
+  for (i = 0; i < ST7565_LCD_DISPLAYS; i++)
+  {
+    started[i] = 0;
+    if (&gs_lcd[i] == pSelf || !gs_lcd[i].io_open) continue;
+    started[i] = (pthread_create(&thread[i], NULL, _lcd_flush_thread,
+      &gs_lcd[i]) == 0);
+    if (!started[i])
+    {
+      /* No thread - flush it here */
+      lcd_select(&gs_lcd[i]);
+      ret = lcd_flush();
+      lcd_select(pSelf);
+      if (retcode == 0) retcode = ret;
+    }
+  }
+  if (pSelf->io_open)
+  {
+    ret = lcd_flush();
+    if (retcode == 0) retcode = ret;
+  }
+  for (i = 0; i < ST7565_LCD_DISPLAYS; i++)
+  {
+    if (!started[i]) continue;
+    pthread_join(thread[i], &pRet);
+    if (retcode == 0) retcode = (int)(intptr_t)pRet;
+  }
+  return retcode;
+}
+/**
+ * @brief Function to turn the picture of the current Display
+ *    180 degrees and the mirror are done by the controller, 90 and 270
+ *    degrees draw on a portrait Canvas (see Orientation). A set up LCD
+ *    gets the new ADC / COM setup and the screen at once, else it is
+ *    sent by @ref lcd_init. The screen is turned with the LCD, what is
+ *    drawn after is in the new orientation.
+ * 
+ * @param wDegrees 0, 90, 180 or 270
+ * @param bMirror 1 - Mirror the picture left to right
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -134 for an orientation the Panel Profile can not show -
+ *        portrait needs a 128 x 64 panel
+ *        Else the Status of @ref lcd_cmd_buf or @ref lcd_flush
+ */
+int lcd_orient ( uint16_t wDegrees, uint8_t bMirror )
+{
+  uint8_t setup[ST7565_LCD_STATE_SETUP];
+  int retcode = 0;
+
+  if (wDegrees % 90 != 0 || wDegrees > 270 || 
+    !_lcd_orient_fits(gp_lcd->panel, wDegrees / 90U))
+  {
+    return ST7565_LCD_ERR(-134);
+  }
+  /* What is drawn on the Canvas goes to the Shadow first */
+  if (ST7565_LCD_PORTRAIT) _lcd_canvas_store();
+  gp_lcd->rotate = (uint8_t)(wDegrees / 90U);
+  gp_lcd->mirror = (bMirror != 0);
+  _lcd_orient_use();
+  if (gp_lcd->powered)
+  {
+    /* ADC and COM, then the Shadow at its new place */
+    _lcd_panel_setup(setup);
+    retcode = lcd_cmd_buf(&setup[1], 2);
+    if (retcode == 0)
+    {
+      lcd_fb_invalidate();
+      retcode = lcd_flush();
+    }
+  }
+  return retcode;
+}
+/**
+ * @brief Function to scroll the text rows up using the Display Start Line
+ *    The RAM is not moved, only the window shown on the Display. So
+ *    scrolling costs the Start Line command and the clearing of the
+ *    newly exposed rows at the bottom - one page per row scrolled.
+ *    The Shadow Frame Buffer is scrolled the same way. In the deferred
+ *    mode everything waits for @ref lcd_flush.
+ *    The cursor is left at the start of the first exposed row.
+ * 
+ * @param bRows Number of text rows to scroll by
+ * @return Status of the Operation
+ *      0 for successful operation
+ *      Else the Status of the @ref lcd_goto or @ref lcd_data in case
+ *      of error, the failed rows are left dirty in the Shadow
+ */
+int lcd_scroll ( uint8_t bRows )
+{
+  static const uint8_t blank[ST7565_LCD_MAX_COLUMNS] = {0};
+  uint8_t r, keep;
+  int retcode = 0;
+
+  if (bRows == 0) return 0;
+  if (bRows > ST7565_LCD_MAX_ROWS) bRows = ST7565_LCD_MAX_ROWS;
+  keep = ST7565_LCD_MAX_ROWS - bRows;
+
+  /* Move the Shadow rows (and what is still to be flushed) up */
+  memmove(gp_lcd->fb.data[0], gp_lcd->fb.data[bRows], 
+    (size_t)keep * ST7565_LCD_MAX_COLUMNS);
+  memmove(gp_lcd->fb.dirty_lo, &gp_lcd->fb.dirty_lo[bRows], keep);
+  memmove(gp_lcd->fb.dirty_hi, &gp_lcd->fb.dirty_hi[bRows], keep);
+
+  /* The exposed rows show the RAM that was at the top - clear it */
+  gp_lcd->scroll = (uint8_t)((gp_lcd->scroll + bRows) & ST7565_LCD_MASK_ROWS);
+  gp_lcd->scroll_pending = 1;
+  for (r = keep; r < ST7565_LCD_MAX_ROWS; r++)
+  {
+    memset(gp_lcd->fb.data[r], 0, ST7565_LCD_MAX_COLUMNS);
+    gp_lcd->fb.dirty_hi[r] = 0;
+    if (gp_lcd->fb.deferred || retcode != 0)
+    {
+      _lcd_fb_mark(0, ST7565_LCD_MAX_COLUMNS, r);
+      continue;
+    }
+    retcode = lcd_goto(0, r);
+    if (retcode == 0)
+    {
+      retcode = lcd_data_buf(blank, sizeof(blank));
+    }
+    if (retcode != 0)
+    {
+      _lcd_fb_mark(0, ST7565_LCD_MAX_COLUMNS, r);
+    }
+  }
+  lcd_goto(0, keep);
+  return retcode;
+}
+/**
+ * @brief Function to select what a new line does on the last text row
+ * 
+ * @param bEnable 0 - Wrap to the top row (Default)
+ *                1 - Scroll the text up with @ref lcd_scroll
+ */
+void lcd_scroll_text ( uint8_t bEnable )
+{
+  gp_lcd->scroll_text = (bEnable != 0);
+}
+/**
+ * @brief Function to select the Font of the text output
+ *    Used by @ref lcd_write and @ref lcd_fb_text, also selected in the
+ *    text with the Format Character ST7565_LCD_FMT_FONT.
+ * 
+ * @param bFont Font number - 0 is the built in 5x7
+ * @return Status of the Operation
+ *      0 for successful operation
+ *      -34 if there is no such Font
+ */
+int lcd_font ( uint8_t bFont )
+{
+  if (bFont >= ST7565_LCD_FONTS || gpa_fonts[bFont]->pages == 0)
+  {
+    return ST7565_LCD_ERR(-34);
+  }
+  gp_lcd->font = gpa_fonts[bFont];
+  gp_lcd->esc.last = 0;
+  return 0;
+}
+
+/**
+ * @brief Function to Initialize the LCD driver with Reset
+ * @details Before calling this we need to call @ref init_io
+ *      - All previous status would be erased and display is refreshed
+ *      - This needs to be done before writing/drawing any thing to the LCD
+ * 
+ * @param None
+ * @return Status code for the Operaiton
+ *        0 for successful operation
+ *        -24 and -25 for error in I/O operations
+ *        Else the last operation @ref lcd_clear
+ */
+int lcd_init_cold ( void )
+{
+  uint8_t setup[ST7565_LCD_STATE_SETUP];
+  int retcode;
+  _lcd_panel_setup(setup);
+  if(_lcd_pin(gp_lcd->a0_pin, 0) != 0) return ST7565_LCD_ERR(-24);
+  gp_lcd->a0_level = 0;
+  if(_lcd_pin(gp_lcd->nrst_pin, 0) != 0) return ST7565_LCD_ERR(-25);
+  /* Reset the LCD */
+  lcd_reset();
+   /* Send Commands */
+  lcd_cmd(setup[0]); /* Setup the Bias Level */
+  lcd_cmd(setup[1]); /* ADC Select */
+  lcd_cmd(setup[2]); /* SHL Select */
+  lcd_cmd(ST7565_LCD_CMD_SET_DISP_START_LINE); /* Initial Display Line */
+  /* Turn On voltage converter (VC=1, VR=0, VF=0) */
+  lcd_cmd(ST7565_LCD_CMD_SET_POWER_CONTROL | 0x4);
+  gp_lcd->io->delay(50000); /* wait for 50% rising */
+  /* Turn On voltage regulator (VC=1, VR=1, VF=0) */
+  lcd_cmd(ST7565_LCD_CMD_SET_POWER_CONTROL | 0x6);
+  gp_lcd->io->delay(50000);
+  /* Turn on voltage follower (VC=1, VR=1, VF=1) */
+  lcd_cmd(ST7565_LCD_CMD_SET_POWER_CONTROL | 0x7);
+  gp_lcd->io->delay(10000); /* Wait */
+  /* Set LCD operating voltage (regulator resistor, ref voltage resistor) */
+  lcd_cmd(setup[3]);
+  lcd_cmd(ST7565_LCD_CMD_DISPLAY_ON);
+  lcd_cmd(ST7565_LCD_CMD_SET_ALLPTS_NORMAL);
+  lcd_bright(gp_lcd->panel->contrast);   
+  
+  /* Finally Clean up the LCD */
+  retcode = lcd_clear();
+  gp_lcd->powered = (retcode == 0);
+  return retcode;
+}
+/**
+ * @brief Function to Initialize the LCD driver
+ * @details Before calling this we need to call @ref init_io
+ *      - If the Persisted State shows that the LCD is still powered and
+ *        set up, the setup and contrast are sent again in one transfer
+ *        and the saved screen is restored - no Reset, power up or blank
+ *        screen. Else the same as @ref lcd_init_cold.
+ *      - This needs to be done before writing/drawing any thing to the LCD
+ * 
+ * @param None
+ * @return Status code for the Operaiton
+ *        0 for successful operation
+ *        -25 for error in I/O operations
+ *        Else the Status of @ref lcd_init_cold, @ref lcd_cmd_buf or 
+ *        @ref lcd_flush
+ */
+int lcd_init()
+{
+  uint8_t cmd[ST7565_LCD_STATE_SETUP + 6];
+  size_t n = 0;
+  int retcode;
+
+  if(!gp_lcd->powered) return lcd_init_cold();
+  /* Keep it out of Reset - the controller state is not known */
+  if(_lcd_pin(gp_lcd->nrst_pin, 1) != 0) return ST7565_LCD_ERR(-25);
+  _lcd_state_invalidate();
+  _lcd_panel_setup(cmd);
+  n = ST7565_LCD_STATE_SETUP;
+  cmd[n++] = ST7565_LCD_CMD_SET_DISP_START_LINE;
+  cmd[n++] = ST7565_LCD_CMD_SET_POWER_CONTROL | 0x7;
+  cmd[n++] = ST7565_LCD_CMD_DISPLAY_ON;
+  cmd[n++] = ST7565_LCD_CMD_SET_ALLPTS_NORMAL;
+  cmd[n++] = ST7565_LCD_CMD_SET_VOLUME_FIRST;
+  cmd[n++] = ST7565_LCD_CMD_SET_VOLUME_SECOND | (gp_lcd->contrast & 0x3f);
+  retcode = lcd_cmd_buf(cmd, n);
+  if(retcode != 0) return retcode;
+  /* The saved screen, in case the last run left it half way */
+  lcd_fb_invalidate();
+  retcode = lcd_flush();
+  if(retcode == 0) lcd_goto(0, 0);
+  return retcode;
+}
+/**
+ * @brief Function to Put the LCD into Deep Sleep mode
+ * 
+ * @param None
+ */
+void lcd_sleep ( void )
+{
+  gp_lcd->powered = 0; /* Needs the full lcd_init after */
+  lcd_cmd(ST7565_LCD_CMD_SET_STATIC_OFF);
+  lcd_cmd(ST7565_LCD_CMD_DISPLAY_OFF);
+  lcd_cmd(ST7565_LCD_CMD_SET_ALLPTS_ON);
+}
+/**
+ * @brief Function to bring back the LCD from Deep Sleep mode
+ *    All display contents are cleared and need to reinitalize
+ *    
+ * @param None
+ */
+void lcd_wakeup ( void )
+{
+  lcd_cmd(ST7565_LCD_CMD_INTERNAL_RESET);
+  _lcd_state_invalidate();
+  lcd_bright(gp_lcd->contrast);
+  lcd_cmd(ST7565_LCD_CMD_SET_ALLPTS_NORMAL);
+  lcd_cmd(ST7565_LCD_CMD_DISPLAY_ON);
+  lcd_cmd(ST7565_LCD_CMD_SET_STATIC_ON);
+  lcd_cmd(ST7565_LCD_CMD_SET_STATIC_REG | 0x03);
+}
+/**
+ * @brief Function to Put and wakup the LCD in Standby mode
+ *      In this mode the display contents are not lost
+ *      its only not visible
+ * @param bWakeUp Used to decide that if we need to enter or exit standby
+ *        0 - Enters into the Standby mode
+ *        1 - Exits the Standby mode
+ */
+void lcd_standby ( uint8_t bWakeUp )
+{
+  if (bWakeUp == 0)
+  { /* Enter standby mode */
+    lcd_cmd(ST7565_LCD_CMD_SET_STATIC_ON);
+    lcd_cmd(ST7565_LCD_CMD_SET_STATIC_REG | 0x03);
+    lcd_cmd(ST7565_LCD_CMD_DISPLAY_OFF);
+    lcd_cmd(ST7565_LCD_CMD_SET_ALLPTS_ON);
+  }
+  else
+  { /* Wake from standby */
+    lcd_cmd(ST7565_LCD_CMD_SET_ALLPTS_NORMAL);
+    lcd_cmd(ST7565_LCD_CMD_DISPLAY_ON);
+  }
+}
+static void _lcd_process_putc_newline ()
+{
+  const uint8_t pages = gp_lcd->font->pages;
+  /* Increment and Set the Location of Cursor - one text row of the Font */
+  gp_lcd->row += pages;
+  if (gp_lcd->row + pages > ST7565_LCD_MAX_ROWS) /* Check if we are at the edge of the Screen */
+  {
+    if (gp_lcd->scroll_text)
+    {
+      /* Move the text up and go on with the cleared last row */
+      uint8_t k = (uint8_t)(gp_lcd->row + pages - ST7565_LCD_MAX_ROWS);
+      lcd_scroll(k);
+      if (k != pages) lcd_goto(0, ST7565_LCD_MAX_ROWS - pages);
+      return;
+    }
+    gp_lcd->row = 0;
+  }
+  lcd_goto(0, gp_lcd->row);
+}
+
+/*
+  Text output understands the LCD Format Characters, so a complete
+  screen can be sent as one string. The arguments are hex numbers of 2
+  digits. The text is decoded by a state machine which keeps its state
+  between calls, so a sequence can be split anywhere (Eg. over reads
+  from a pipe). The glyphs and the FMT_RAW data landing on one row are
+  assembled first and sent to the LCD in a single transfer.
+  An invalid hex digit ends the sequence, the character is then taken
+  as normal text. Bytes that are not UTF-8 are dropped, apart from a
+  lone 0x80 which is the Cursor.
+*/
+
+/* Format decoder states */
+#define ST7565_LCD_ESC_TEXT                  0 /* Normal characters */
+#define ST7565_LCD_ESC_ARGS                  1 /* Argument bytes */
+#define ST7565_LCD_ESC_RAW                   2 /* FMT_RAW data bytes */
+
+/**
+ *  Function to get the value of a hex digit, -1 if it is not one
+ */
+static inline int _lcd_esc_hex ( uint8_t c )
+{
+  if ((uint8_t)(c - '0') < 10) return c - '0';
+  c |= 0x20; /* Lower case */
+  if ((uint8_t)(c - 'a') < 6) return c - 'a' + 10;
+  return -1;
+}
+/**
+ *  Function to send out the assembled part of the row
+ *    The lower pages of a taller Font follow with an addressing each,
+ *    pages below the last row are cut off.
+ */
+static void _lcd_esc_send ( void )
+{
+  const uint8_t pages = gp_lcd->font->pages;
+  const size_t n = gp_lcd->esc.n;
+  uint16_t row = gp_lcd->row, column = gp_lcd->column;
+  uint8_t p;
+
+  if (n == 0) return;
+  gp_lcd->esc.retcode |= lcd_data_buf(gp_lcd->esc.line[0], n);
+  gp_lcd->esc.n = 0;
+  if (pages == 1) return;
+  for (p = 1; p < pages && row + p < ST7565_LCD_MAX_ROWS; p++)
+  {
+    gp_lcd->esc.retcode |= lcd_goto((uint8_t)(column - n),
+      (uint8_t)(row + p));
+    gp_lcd->esc.retcode |= lcd_data_buf(gp_lcd->esc.line[p], n);
+  }
+  /* Back to the Cursor - past the edge the next text starts a new row
+     which does its own addressing */
+  if (column < ST7565_LCD_MAX_COLUMNS)
+  {
+    lcd_goto((uint8_t)column, (uint8_t)row);
+  }
+  gp_lcd->row = row;
+  gp_lcd->column = column;
+}
+/**
+ *  Function to add a character glyph at the cursor, the text goes on at
+ *  the next row if it does not fit
+ */
+static void _lcd_esc_glyph ( const uint8_t *pGlyph, uint8_t width )
+{
+  const uint8_t pages = gp_lcd->font->pages;
+  uint8_t p;
+
+  /* Get the Cursor shift for the current character */
+  gp_lcd->column += width;
+
+  /* Check if we have spilled over the boundary */
+  if (gp_lcd->column >= ST7565_LCD_MAX_COLUMNS) 
+  {
+    _lcd_esc_send();
+    _lcd_process_putc_newline();
+    gp_lcd->column += width; 
+  }
+  for (p = 0; p < pages; p++)
+  {
+    memcpy(&gp_lcd->esc.line[p][gp_lcd->esc.n], &pGlyph[p * width], width);
+  }
+  gp_lcd->esc.n += width;
+  gp_lcd->esc.last = width;
+}
+/**
+ *  Function to add one graphic data column at the cursor - on the top
+ *  page of the text row, the pages below are left blank
+ */
+static void _lcd_esc_column ( uint8_t bData )
+{
+  uint8_t p;
+  if (gp_lcd->column >= ST7565_LCD_MAX_COLUMNS)
+  {
+    _lcd_esc_send();
+    _lcd_process_putc_newline();
+  }
+  for (p = 1; p < gp_lcd->font->pages; p++)
+  {
+    gp_lcd->esc.line[p][gp_lcd->esc.n] = 0;
+  }
+  gp_lcd->esc.line[0][gp_lcd->esc.n++] = bData;
+  ++gp_lcd->column;
+}
+/**
+ *  Function to remove the previous character and step back over it
+ *    Only the width of the last glyph is known, further back the
+ *    nominal width of the Font is used.
+ */
+static void _lcd_esc_backspace ( void )
+{
+  static const uint8_t blank[ST7565_LCD_MAX_COLUMNS] = {0};
+  const uint8_t pages = gp_lcd->font->pages;
+  uint8_t width = gp_lcd->esc.last ? gp_lcd->esc.last : gp_lcd->font->width;
+  uint16_t row = gp_lcd->row, column = gp_lcd->column;
+  uint8_t p;
+
+  _lcd_esc_send();
+  gp_lcd->esc.last = 0;
+  if (column >= width)
+  {
+    column -= width;
+  }
+  else if (row >= pages)
+  {
+    /* Last character of the previous row */
+    row -= pages;
+    column = (ST7565_LCD_MAX_COLUMNS / width - 1) * width;
+  }
+  else return;
+  for (p = 0; p < pages && row + p < ST7565_LCD_MAX_ROWS; p++)
+  {
+    lcd_goto((uint8_t)column, (uint8_t)(row + p));
+    gp_lcd->esc.retcode |= lcd_data_buf(blank, width);
+  }
+  lcd_goto((uint8_t)column, (uint8_t)row);
+}
+/**
+ *  Function to add the glyph of a character at the cursor - characters
+ *  the Font has no glyph for are dropped
+ */
+static void _lcd_esc_char ( uint32_t cp )
+{
+  const uint8_t *pGlyph;
+  uint8_t width;
+  pGlyph = _lcd_font_glyph(gp_lcd->font, cp, &width);
+  if (pGlyph != NULL) _lcd_esc_glyph(pGlyph, width);
+}
+/**
+ *  Function to perform a Format Character once its arguments are in
+ */
+static void _lcd_esc_perform ( void )
+{
+  uint8_t *a = gp_lcd->esc.args;
+  const uint8_t *pSpace;
+  uint8_t width;
+  unsigned i;
+  switch (gp_lcd->esc.code)
+  {
+  case ST7565_LCD_FMT_SPACE:
+    pSpace = _lcd_font_glyph(gp_lcd->font, ' ', &width);
+    for (i = 0; i < a[0] && pSpace != NULL; i++)
+      _lcd_esc_glyph(pSpace, width);
+    break;
+  case ST7565_LCD_FMT_RAW:
+    /* Size is Low Byte first */
+    gp_lcd->esc.raw = (uint16_t)(a[0] | (a[1] << 8));
+    if (gp_lcd->esc.raw) gp_lcd->esc.state = ST7565_LCD_ESC_RAW;
+    break;
+  case ST7565_LCD_FMT_COORDINATES:
+    _lcd_esc_send();
+    gp_lcd->esc.retcode |= lcd_goto(a[0] & ST7565_LCD_MASK_COLUMNS, 
+      a[1] & ST7565_LCD_MASK_ROWS);
+    break;
+  case ST7565_LCD_FMT_COLUMNOFFSET:
+    for (i = 0; i < a[0]; i++) _lcd_esc_column(0);
+    break;
+  case ST7565_LCD_FMT_FONT:
+    /* The text so far goes out in its own Font */
+    _lcd_esc_send();
+    gp_lcd->esc.retcode |= lcd_font(a[0]);
+    break;
+  default:
+    break;
+  }
+}
+/**
+ * @brief Function to Print text with Format Characters at the current
+ *    Cursor location
+ *    The text is UTF-8 and can be given in pieces of any size, a Format
+ *    sequence or a character split between two calls is completed by
+ *    the second one.
+ * 
+ * @param pText Characters to print - not Null Terminated
+ * @param len Number of characters
+ * @return Status of the Operation
+ *      0 for successful operation
+ *      Else the Status of the LCD operations in case of error
+ */
+int lcd_write ( const char *pText, size_t len )
+{
+  const uint8_t *p = (const uint8_t *)pText, *pEnd = p + len;
+  uint32_t cp;
+  uint8_t c;
+  int v;
+
+  gp_lcd->esc.retcode = 0;
+  while (p < pEnd)
+  {
+    c = *p++;
+    if (gp_lcd->esc.state != ST7565_LCD_ESC_TEXT)
+    {
+      v = _lcd_esc_hex(c);
+      if (v < 0)
+      {
+        /* Broken sequence - drop it and print the character */
+        gp_lcd->esc.state = ST7565_LCD_ESC_TEXT;
+        gp_lcd->esc.nibble = 0;
+        --p;
+        continue;
+      }
+      if (!gp_lcd->esc.nibble)
+      {
+        gp_lcd->esc.hi = (uint8_t)v;
+        gp_lcd->esc.nibble = 1;
+        continue;
+      }
+      gp_lcd->esc.nibble = 0;
+      c = (uint8_t)((gp_lcd->esc.hi << 4) | v);
+      if (gp_lcd->esc.state == ST7565_LCD_ESC_RAW)
+      {
+        _lcd_esc_column(c);
+        if (--gp_lcd->esc.raw == 0) gp_lcd->esc.state = ST7565_LCD_ESC_TEXT;
+        continue;
+      }
+      gp_lcd->esc.args[gp_lcd->esc.have++] = c;
+      if (gp_lcd->esc.have == gp_lcd->esc.nargs)
+      {
+        gp_lcd->esc.state = ST7565_LCD_ESC_TEXT;
+        _lcd_esc_perform();
+      }
+      continue;
+    }
+
+    /* Characters are UTF-8 - a lone 0x80 is the Cursor */
+    v = _lcd_utf8(&gp_lcd->esc.utf8, c, &cp);
+    if (v == 0) continue;
+    if (v < 0 && c != (uint8_t)ST7565_LCD_FMT_CURSOR) continue;
+    if (v > 0 && cp >= 0x80)
+    {
+      _lcd_esc_char(cp);
+      continue;
+    }
+    switch (c)
+    {
+    case ST7565_LCD_FMT_SPACE:
+    case ST7565_LCD_FMT_FONT:
+    case ST7565_LCD_FMT_COLUMNOFFSET:
+    case ST7565_LCD_FMT_RAW:
+    case ST7565_LCD_FMT_COORDINATES:
+      gp_lcd->esc.state = ST7565_LCD_ESC_ARGS;
+      gp_lcd->esc.code = c;
+      gp_lcd->esc.have = 0;
+      gp_lcd->esc.nargs = (c == ST7565_LCD_FMT_RAW || 
+        c == ST7565_LCD_FMT_COORDINATES) ? 2 : 1;
+      break;
+    case ST7565_LCD_FMT_NEWINE:
+      _lcd_esc_send();
+      _lcd_process_putc_newline();
+      break;
+    case ST7565_LCD_FMT_BACKSPACE:
+      _lcd_esc_backspace();
+      break;
+    case (uint8_t)ST7565_LCD_FMT_CURSOR:
+    {
+      /* Block of the nominal width, the full height of the Font */
+      uint8_t cursor[ST7565_LCD_FONT_MAXPAGES * ST7565_LCD_MAX_COLUMNS];
+      const uint8_t width = gp_lcd->font->width;
+      const uint8_t pages = gp_lcd->font->pages;
+      memset(cursor, 0xFF, (size_t)(pages - 1) * width);
+      memset(&cursor[(pages - 1) * width], 0xFC, width);
+      _lcd_esc_glyph(cursor, width);
+      break;
+    }
+    default:
+      _lcd_esc_char(c);
+      break;
+    }
+  }
+  _lcd_esc_send();
+  return gp_lcd->esc.retcode;
+}
+/**
+ * @brief Function to Print one character at the current Cursor location
+ *    Format Characters can be given one character at a time.
+ * 
+ * @param c Character to print
+ */
+void lcd_putc ( char c )
+{
+  lcd_write(&c, 1);
+}
+/**
+ * @brief Function to Print a string at the current Cursor location
+ *    All the glyphs landing on one row are sent to the LCD in a single
+ *    transfer, see @ref lcd_write for the Format Characters.
+ * 
+ * @param sText Null Terminated String
+ * @return Status of the Operation
+ *      0 for successful operation
+ *      Else the Status of the LCD operations in case of error
+ */
+int lcd_puts ( const char *sText )
+{
+  return lcd_write(sText, strlen(sText));
+}
+
+/************************************************************************/
+/* Shadow Frame Buffer Drawing                                          */
+/************************************************************************/
+
+/*
+  Drawing at any pixel location into the Shadow Frame Buffer, the result
+  is sent to the LCD with @ref lcd_flush.
+  - X is the column 0 - 127 from the left, Y the pixel line from the top.
+    Y = 0 is the top line of row (page) 0, same as the text rows.
+  - In every byte the top pixel is the MSB (as in the font).
+  - Bitmaps are given in the same page layout as the LCD: 'pages' rows
+    of 'width' bytes each, one byte for every column of 8 pixels.
+  - A bitmap placed at a Y which is not on a page boundary is split over
+    two pages, each part shifted and merged with a mask. Eight columns
+    are processed at a time as the bytes of a 64 bit word - the shifts
+    are done on the whole word and the bits that crossed into the
+    neighbouring byte lanes are masked off.
+*/
+
+/* Blit modes */
+#define ST7565_LCD_BLIT_COPY                 0 /* Replace covered pixels */
+#define ST7565_LCD_BLIT_OR                   1 /* Set the BLACK pixels */
+#define ST7565_LCD_BLIT_CLEAR                2 /* Clear the BLACK pixels */
+
+/* Size of the drawing in pixels - the Canvas in portrait, else the
+   Shadow with the pages of the Panel Profile */
+#define ST7565_LCD_FB_WIDTH                  (ST7565_LCD_PORTRAIT ? \
+  ST7565_LCD_CANVAS_COLUMNS : ST7565_LCD_MAX_COLUMNS)
+#define ST7565_LCD_FB_HEIGHT                 (ST7565_LCD_PORTRAIT ? \
+  ST7565_LCD_CANVAS_ROWS * 8U : gp_lcd->panel->pages * 8U)
+
+/* Replicate a byte in all the lanes of a 64 bit word */
+#define ST7565_LCD_LANES(b)                  (0x0101010101010101ULL * (b))
+
+/**
+ *  Function to get a page of the drawing - of the Canvas in portrait
+ */
+static inline uint8_t *_lcd_fb_page ( uint8_t bRow )
+{
+  return ST7565_LCD_PORTRAIT ? 
+    gp_lcd->fb.canvas[bRow] : gp_lcd->fb.data[bRow];
+}
+/**
+ *  Function to mark the columns [bLo, bHi) of a drawn page as modified -
+ *  in portrait the blocks of 8 columns of the Canvas
+ */
+static inline void _lcd_fb_drawn ( uint8_t bLo, uint8_t bHi, uint8_t bRow )
+{
+  if (!ST7565_LCD_PORTRAIT)
+  {
+    _lcd_fb_mark(bLo, bHi, bRow);
+    return;
+  }
+  gp_lcd->fb.canvas_dirty[bRow] |= (uint8_t)((0xFFU << (bLo / 8)) & 
+    (0xFFU >> (7 - (bHi - 1) / 8)));
+}
+/**
+ *  Function to merge the columns of one source page into one page of the
+ *  Shadow, the source bits are shifted right (top part) by 'shift' or
+ *  left (bottom part) by '-shift' and limited to 'mask' in each byte.
+ */
+static void _lcd_fb_blit_page ( uint8_t bRow, uint8_t bColumn,
+  const uint8_t *pSrc, unsigned len, int shift, uint8_t mask, uint8_t bMode )
+{
+  uint8_t *pDst = _lcd_fb_page(bRow) + bColumn;
+  const uint64_t lmask = ST7565_LCD_LANES(mask);
+  uint64_t v, d, n;
+  unsigned c = 0, first = len, last = 0;
+
+  /* Eight columns at a time */
+  for (; c + 8 <= len; c += 8)
+  {
+    memcpy(&v, &pSrc[c], 8);
+    memcpy(&d, &pDst[c], 8);
+    v = ((shift >= 0) ? (v >> shift) : (v << -shift)) & lmask;
+    if (bMode == ST7565_LCD_BLIT_OR)         n = d | v;
+    else if (bMode == ST7565_LCD_BLIT_CLEAR) n = d & ~v;
+    else                                     n = (d & ~lmask) | v;
+    if (n != d)
+    {
+      memcpy(&pDst[c], &n, 8);
+      if (first == len) first = c;
+      last = c + 8;
+    }
+  }
+  /* Remaining columns */
+  for (; c < len; c++)
+  {
+    uint8_t b = (uint8_t)(((shift >= 0) ? (pSrc[c] >> shift) : 
+      (pSrc[c] << -shift)) & mask);
+    uint8_t o = pDst[c];
+    if (bMode == ST7565_LCD_BLIT_OR)         pDst[c] = o | b;
+    else if (bMode == ST7565_LCD_BLIT_CLEAR) pDst[c] = o & ~b;
+    else                                     pDst[c] = (o & ~mask) | b;
+    if (pDst[c] != o)
+    {
+      if (first == len) first = c;
+      last = c + 1;
+    }
+  }
+  if (first < last)
+  {
+    _lcd_fb_drawn((uint8_t)(bColumn + first), (uint8_t)(bColumn + last), 
+      bRow);
+  }
+}
+/**
+ * @brief Function to draw a bitmap at any pixel location in the Shadow
+ *    Frame Buffer, the parts outside the display are clipped.
+ * 
+ * @param x Column of the left edge, can be negative
+ * @param y Pixel line of the top edge, can be negative
+ * @param pSrc Bitmap in the page layout - pages x width bytes
+ * @param width Number of columns in the bitmap
+ * @param pages Number of 8 pixel pages in the bitmap
+ * @param bMode One of ST7565_LCD_BLIT_COPY, _OR, _CLEAR
+ */
+void lcd_fb_blit ( int x, int y, const uint8_t *pSrc, unsigned width,
+  unsigned pages, uint8_t bMode )
+{
+  unsigned p, skip = 0, len = width;
+  int shift, row;
+
+  /* Clip the columns */
+  if (x < 0)
+  {
+    if ((unsigned)-x >= width) return;
+    skip = (unsigned)-x;
+    len -= skip;
+    x = 0;
+  }
+  if (x >= (int)ST7565_LCD_FB_WIDTH) return;
+  if (len > ST7565_LCD_FB_WIDTH - (unsigned)x)
+    len = ST7565_LCD_FB_WIDTH - (unsigned)x;
+
+  /* Split Y into the page and the shift inside the page */
+  shift = ((y % 8) + 8) % 8;
+  row = (y - shift) / 8;
+
+  for (p = 0; p < pages; p++, row++)
+  {
+    const uint8_t *pLine = &pSrc[p * width + skip];
+    /* Top part in this page */
+    if (row >= 0 && row < (int)(ST7565_LCD_FB_HEIGHT / 8))
+    {
+      _lcd_fb_blit_page((uint8_t)row, (uint8_t)x, pLine, len, shift,
+        (uint8_t)(0xFF >> shift), bMode);
+    }
+    /* Bottom part spills into the next page */
+    if (shift != 0 && row + 1 >= 0 && 
+      row + 1 < (int)(ST7565_LCD_FB_HEIGHT / 8))
+    {
+      _lcd_fb_blit_page((uint8_t)(row + 1), (uint8_t)x, pLine, len,
+        shift - 8, (uint8_t)(0xFF << (8 - shift)), bMode);
+    }
+  }
+}
+/**
+ * @brief Function to draw a string at any pixel location in the Shadow
+ *    Frame Buffer with the current Font - '\n' moves to the next line
+ *    below the starting location, there is no wrapping at the right edge.
+ * 
+ * @param x Column of the left edge of the first character
+ * @param y Pixel line of the top edge
+ * @param sText Null Terminated String
+ * @param bMode One of ST7565_LCD_BLIT_COPY, _OR, _CLEAR
+ */
+void lcd_fb_text ( int x, int y, const char *sText, uint8_t bMode )
+{
+  const lcd_font_t *pFont = gp_lcd->font;
+  const uint8_t *pGlyph;
+  lcd_utf8_t utf8 = { 0, 0 };
+  int x0 = x;
+  uint32_t cp;
+  uint8_t width;
+
+  for (; *sText != 0; sText++)
+  {
+    if (_lcd_utf8(&utf8, (uint8_t)*sText, &cp) <= 0) continue;
+    if (cp == '\n')
+    {
+      x = x0;
+      y += pFont->pages * ST7565_LCD_PARAM_FONT_CHARHEIGHT;
+      continue;
+    }
+    pGlyph = _lcd_font_glyph(pFont, cp, &width);
+    if (pGlyph == NULL) continue;
+    lcd_fb_blit(x, y, pGlyph, width, pFont->pages, bMode);
+    x += width;
+  }
+}
+
+/************************************************************************/
+/* Drawing Primitives                                                   */
+/************************************************************************/
+
+/*
+  Basic shapes drawn straight into the page layout of the Shadow Frame
+  Buffer, the result is sent to the LCD with @ref lcd_flush.
+  - Same coordinates as the blitter: X from the left, Y from the top.
+  - Color is BLACK, WHITE or INVERT - INVERT flips the pixels (XOR) and
+    drawing the same shape again restores what was there, handy for a
+    cursor or a selection.
+  - Everything ends up as spans: a horizontal span is one bit mask
+    applied over a run of columns of a single page, a vertical span is
+    a masked byte on its first and last page and whole bytes in between.
+  - Shapes are clipped to the display.
+*/
+
+/**
+ *  Function to apply a pixel mask with a color on the columns
+ *  [bLo, bHi) of a page in the Shadow
+ */
+static void _lcd_fb_apply ( uint8_t bRow, uint8_t bLo, uint8_t bHi,
+  uint8_t mask, uint8_t color )
+{
+  uint8_t *p = _lcd_fb_page(bRow);
+  uint8_t c, o;
+  uint8_t first = bHi, last = 0;
+
+  for (c = bLo; c < bHi; c++)
+  {
+    o = p[c];
+    if (color == BLACK)       p[c] = o | mask;
+    else if (color == INVERT) p[c] = o ^ mask;
+    else                      p[c] = o & (uint8_t)~mask;
+    if (p[c] != o)
+    {
+      if (first == bHi) first = c;
+      last = c + 1;
+    }
+  }
+  if (first < last) _lcd_fb_drawn(first, last, bRow);
+}
+/**
+ *  Function to fill the rectangle of columns [x0, x1) and pixel lines
+ *  [y0, y1) - Already clipped to the Shadow
+ */
+static void _lcd_fb_span ( int x0, int x1, int y0, int y1, uint8_t color )
+{
+  int row = y0 / 8, last = (y1 - 1) / 8;
+  uint8_t mask;
+
+  for (; row <= last; row++)
+  {
+    mask = 0xFF;
+    if (row == y0 / 8) mask &= (uint8_t)(0xFF >> (y0 % 8));
+    if (row == last)   mask &= (uint8_t)(0xFF << (7 - ((y1 - 1) % 8)));
+    _lcd_fb_apply((uint8_t)row, (uint8_t)x0, (uint8_t)x1, mask, color);
+  }
+}
+/**
+ * @brief Function to fill a rectangle in the Shadow Frame Buffer
+ * 
+ * @param x Column of the left edge
+ * @param y Pixel line of the top edge
+ * @param w Width in pixels
+ * @param h Height in pixels
+ * @param color BLACK, WHITE or INVERT
+ */
+void lcd_fb_fill_rect ( int x, int y, int w, int h, uint8_t color )
+{
+  int x1 = x + w, y1 = y + h;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 > (int)ST7565_LCD_FB_WIDTH) x1 = ST7565_LCD_FB_WIDTH;
+  if (y1 > (int)ST7565_LCD_FB_HEIGHT) y1 = ST7565_LCD_FB_HEIGHT;
+  if (x >= x1 || y >= y1) return;
+  _lcd_fb_span(x, x1, y, y1, color);
+}
+/**
+ * @brief Function to set one pixel in the Shadow Frame Buffer
+ * 
+ * @param x Column
+ * @param y Pixel line
+ * @param color BLACK, WHITE or INVERT
+ */
+void lcd_fb_pixel ( int x, int y, uint8_t color )
+{
+  lcd_fb_fill_rect(x, y, 1, 1, color);
+}
+/**
+ * @brief Function to draw a horizontal line - both ends included
+ * 
+ * @param x0 Starting Column
+ * @param x1 Ending Column
+ * @param y Pixel line
+ * @param color BLACK, WHITE or INVERT
+ */
+void lcd_fb_hline ( int x0, int x1, int y, uint8_t color )
+{
+  if (x1 < x0) { int t = x0; x0 = x1; x1 = t; }
+  lcd_fb_fill_rect(x0, y, x1 - x0 + 1, 1, color);
+}
+/**
+ * @brief Function to draw a vertical line - both ends included
+ * 
+ * @param x Column
+ * @param y0 Starting Pixel line
+ * @param y1 Ending Pixel line
+ * @param color BLACK, WHITE or INVERT
+ */
+void lcd_fb_vline ( int x, int y0, int y1, uint8_t color )
+{
+  if (y1 < y0) { int t = y0; y0 = y1; y1 = t; }
+  lcd_fb_fill_rect(x, y0, 1, y1 - y0 + 1, color);
+}
+/**
+ * @brief Function to draw a line between two points (Bresenham)
+ *    Every run of pixels on the same line (or column for steep lines)
+ *    is drawn as one span, no pixel is drawn twice.
+ * 
+ * @param x0 Starting Column
+ * @param y0 Starting Pixel line
+ * @param x1 Ending Column
+ * @param y1 Ending Pixel line
+ * @param color BLACK, WHITE or INVERT
+ */
+void lcd_fb_line ( int x0, int y0, int x1, int y1, uint8_t color )
+{
+  int dx = abs(x1 - x0), dy = abs(y1 - y0);
+  int sx = (x0 < x1) ? 1 : -1, sy = (y0 < y1) ? 1 : -1;
+  int err, i, start;
+
+  if (dx >= dy)
+  {
+    /* Step along X, a new span every time Y moves */
+    err = dx / 2;
+    start = x0;
+    for (i = 0; i < dx; i++)
+    {
+      err -= dy;
+      if (err < 0)
+      {
+        lcd_fb_hline(start, x0, y0, color);
+        y0 += sy;
+        err += dx;
+        start = x0 + sx;
+      }
+      x0 += sx;
+    }
+    lcd_fb_hline(start, x0, y0, color);
+  }
+  else
+  {
+    /* Step along Y, a new span every time X moves */
+    err = dy / 2;
+    start = y0;
+    for (i = 0; i < dy; i++)
+    {
+      err -= dx;
+      if (err < 0)
+      {
+        lcd_fb_vline(x0, start, y0, color);
+        x0 += sx;
+        err += dy;
+        start = y0 + sy;
+      }
+      y0 += sy;
+    }
+    lcd_fb_vline(x0, start, y0, color);
+  }
+}
+/**
+ * @brief Function to draw the outline of a rectangle
+ * 
+ * @param x Column of the left edge
+ * @param y Pixel line of the top edge
+ * @param w Width in pixels
+ * @param h Height in pixels
+ * @param color BLACK, WHITE or INVERT
+ */
+void lcd_fb_rect ( int x, int y, int w, int h, uint8_t color )
+{
+  if (w <= 0 || h <= 0) return;
+  lcd_fb_fill_rect(x, y, w, 1, color);
+  if (h > 1) lcd_fb_fill_rect(x, y + h - 1, w, 1, color);
+  if (h > 2)
+  {
+    /* Sides without the corners */
+    lcd_fb_fill_rect(x, y + 1, 1, h - 2, color);
+    if (w > 1) lcd_fb_fill_rect(x + w - 1, y + 1, 1, h - 2, color);
+  }
+}
+/**
+ *  Function to draw the mirror images of a point of the first octant
+ *  of a circle, skipping the ones that fall on the same pixel
+ */
+static void _lcd_fb_circle_points ( int xc, int yc, int x, int y,
+  uint8_t color )
+{
+  lcd_fb_pixel(xc + x, yc + y, color);
+  lcd_fb_pixel(xc + x, yc - y, color);
+  if (x != 0)
+  {
+    lcd_fb_pixel(xc - x, yc + y, color);
+    lcd_fb_pixel(xc - x, yc - y, color);
+  }
+  if (x != y)
+  {
+    lcd_fb_pixel(xc + y, yc + x, color);
+    lcd_fb_pixel(xc - y, yc + x, color);
+    if (x != 0)
+    {
+      lcd_fb_pixel(xc + y, yc - x, color);
+      lcd_fb_pixel(xc - y, yc - x, color);
+    }
+  }
+}
+/**
+ * @brief Function to draw the outline of a circle (Midpoint algorithm)
+ * 
+ * @param xc Column of the Center
+ * @param yc Pixel line of the Center
+ * @param r Radius in pixels
+ * @param color BLACK, WHITE or INVERT
+ */
+void lcd_fb_circle ( int xc, int yc, int r, uint8_t color )
+{
+  int x = 0, y = r, d = 1 - r;
+
+  if (r < 0) return;
+  if (r == 0)
+  {
+    lcd_fb_pixel(xc, yc, color);
+    return;
+  }
+  while (x <= y)
+  {
+    _lcd_fb_circle_points(xc, yc, x, y, color);
+    ++x;
+    if (d < 0)
+    {
+      d += 2 * x + 1;
+    }
+    else
+    {
+      --y;
+      d += 2 * (x - y) + 1;
+    }
+  }
+}
+
+/* Edge crossings of one pixel line kept on the stack - Polygons with
+   more corners get a node list allocated to fit */
+#define ST7565_LCD_POLY_MAXNODES             32
+
+/**
+ * @brief Function to fill a polygon (Even-Odd rule)
+ *    Each pixel line is filled with spans between the pairs of edge
+ *    crossings, a pixel is inside if its center is inside.
+ * 
+ * @param pX Columns of the corners
+ * @param pY Pixel lines of the corners
+ * @param n Number of corners - the last one connects to the first
+ * @param color BLACK, WHITE or INVERT
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -37 if the node list can not be allocated
+ */
+int lcd_fb_fill_polygon ( const int *pX, const int *pY, int n,
+  uint8_t color )
+{
+  int stack[ST7565_LCD_POLY_MAXNODES];
+  int *nodes = stack;
+  int ymin, ymax, y, i, j, k, cnt;
+
+  if (n < 3) return 0;
+  /* Each edge crosses a pixel line at most once */
+  if (n > ST7565_LCD_POLY_MAXNODES)
+  {
+    nodes = malloc((size_t)n * sizeof(int));
+    if (nodes == NULL) return ST7565_LCD_ERR(-37);
+  }
+  ymin = ymax = pY[0];
+  for (i = 1; i < n; i++)
+  {
+    if (pY[i] < ymin) ymin = pY[i];
+    if (pY[i] > ymax) ymax = pY[i];
+  }
+  if (ymin < 0) ymin = 0;
+  if (ymax >= (int)ST7565_LCD_FB_HEIGHT) ymax = ST7565_LCD_FB_HEIGHT - 1;
+
+  for (y = ymin; y <= ymax; y++)
+  {
+    /* Crossings of the edges with the center of this pixel line,
+       in fixed point with 1 bit of fraction */
+    cnt = 0;
+    for (i = 0, j = n - 1; i < n; j = i++)
+    {
+      int y2 = 2 * y + 1;
+      int yi = 2 * pY[i], yj = 2 * pY[j];
+      if ((yi < y2 && yj >= y2) || (yj < y2 && yi >= y2))
+      {
+        int x2 = 2 * pX[i] + 
+          (y2 - yi) * (2 * pX[j] - 2 * pX[i]) / (yj - yi);
+        /* Insertion sort */
+        for (k = cnt++; k > 0 && nodes[k - 1] > x2; k--)
+        {
+          nodes[k] = nodes[k - 1];
+        }
+        nodes[k] = x2;
+      }
+    }
+    /* Pixels whose center is between a pair of crossings */
+    for (i = 0; i + 1 < cnt; i += 2)
+    {
+      int xa = nodes[i] >> 1, xb = (nodes[i + 1] >> 1) - 1;
+      if (xb >= xa) lcd_fb_hline(xa, xb, y, color);
+    }
+  }
+  if (nodes != stack) free(nodes);
+  return 0;
+}
+
+/************************************************************************/
+/* Bitmap Import                                                        */
+/************************************************************************/
+
+/*
+  Images are usually made row by row - one bit per pixel, the leftmost
+  pixel in the MSB (PBM) or LSB (XBM) of a byte. The LCD needs a byte
+  for each column of 8 pixels instead, so every block of 8 x 8 pixels is
+  bit transposed: 8 row bytes in, 8 column bytes out.
+  - Portable kernel: the three delta swaps on a 64 bit word of
+    @ref _lcd_transpose8 (see Orientation).
+  - SSE2 kernel (x86 build machines): 16 rows are loaded at once and
+    each _mm_movemask_epi8 collects one column of two pages.
+  On the Pi the portable kernel is used, it needs no branches and only
+  a few operations for each 64 pixels. Built with ST7565_NO_SSE2 the
+  portable kernel is used on x86 too (see tests/test_image.c).
+*/
+#if defined(__SSE2__) && !defined(ST7565_NO_SSE2)
+#define ST7565_LCD_IMAGE_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Largest image file accepted */
+#define ST7565_LCD_IMAGE_MAXFILE             (1024UL * 1024UL)
+
+/**
+ * @brief Function to convert a row-major 1 bit per pixel image into
+ *    the page layout of the LCD
+ * 
+ * @param pImage Image rows, the left pixel is the MSB of the first byte
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param stride Bytes from one image row to the next
+ * @param pPages Output of 'pages' x ST7565_LCD_MAX_COLUMNS bytes, the
+ *        parts not covered by the image are cleared
+ * @param pages Number of pages in the output
+ */
+void lcd_image_convert ( const uint8_t *pImage, unsigned width,
+  unsigned height, unsigned stride, uint8_t *pPages, unsigned pages )
+{
+  uint8_t rows[16];
+  unsigned p, g, r, groups;
+
+  if (width > ST7565_LCD_MAX_COLUMNS) width = ST7565_LCD_MAX_COLUMNS;
+  if (height > pages * 8) height = pages * 8;
+  groups = (width + 7) / 8;
+  memset(pPages, 0, (size_t)pages * ST7565_LCD_MAX_COLUMNS);
+
+  for (p = 0; p * 8 < height; p++)
+  {
+    uint8_t *pOut = &pPages[p * ST7565_LCD_MAX_COLUMNS];
+#ifdef ST7565_LCD_IMAGE_SSE2
+    /* Two pages at a time when both are fully inside the image */
+    if (p * 8 + 16 <= height)
+    {
+      for (g = 0; g < groups; g++)
+      {
+        __m128i v;
+        int c;
+        /* Last row in byte 0 so that the first row ends up in the MSB */
+        for (r = 0; r < 16; r++)
+          rows[15 - r] = pImage[(p * 8 + r) * stride + g];
+        memcpy(&v, rows, 16);
+        for (c = 0; c < 8; c++)
+        {
+          unsigned m = (unsigned)_mm_movemask_epi8(v);
+          pOut[g * 8 + c] = (uint8_t)(m >> 8);
+          pOut[ST7565_LCD_MAX_COLUMNS + g * 8 + c] = (uint8_t)m;
+          v = _mm_slli_epi64(v, 1);
+        }
+      }
+      ++p;
+      continue;
+    }
+#endif
+    for (g = 0; g < groups; g++)
+    {
+      for (r = 0; r < 8; r++)
+      {
+        rows[r] = (p * 8 + r < height) ? 
+          pImage[(p * 8 + r) * stride + g] : 0;
+      }
+      _lcd_transpose8(rows, &pOut[g * 8]);
+    }
+  }
+  /* Drop the padding bits past the right edge */
+  if (width % 8)
+  {
+    for (p = 0; p < pages; p++)
+    {
+      memset(&pPages[p * ST7565_LCD_MAX_COLUMNS + width], 0, 
+        groups * 8 - width);
+    }
+  }
+}
+/**
+ *  Function to read the next unsigned number of a PBM header, skipping
+ *  white space and comments
+ */
+static int _lcd_image_pbm_number ( const uint8_t **ppText, 
+  const uint8_t *pEnd )
+{
+  const uint8_t *p = *ppText;
+  int value = 0, digits = 0;
+  while (p < pEnd)
+  {
+    if (*p == '#')
+      while (p < pEnd && *p != '\n') p++;
+    else if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+      p++;
+    else
+      break;
+  }
+  while (p < pEnd && *p >= '0' && *p <= '9' && value < 100000)
+  {
+    value = value * 10 + (*p++ - '0');
+    digits++;
+  }
+  *ppText = p;
+  return digits ? value : -1;
+}
+/**
+ *  Function to parse a binary PBM (P4) image in memory
+ *  
+ * @return Pointer to the first image row or NULL on format error
+ */
+static const uint8_t *_lcd_image_pbm ( const uint8_t *pFile, size_t len,
+  unsigned *pWidth, unsigned *pHeight )
+{
+  const uint8_t *p = pFile + 2, *pEnd = pFile + len;
+  int w, h;
+  if (len < 3 || pFile[0] != 'P' || pFile[1] != '4') return NULL;
+  w = _lcd_image_pbm_number(&p, pEnd);
+  h = _lcd_image_pbm_number(&p, pEnd);
+  if (w <= 0 || h <= 0 || p >= pEnd) return NULL;
+  ++p; /* Single white space before the data */
+  if ((size_t)(pEnd - p) < (size_t)((w + 7) / 8) * (size_t)h) return NULL;
+  *pWidth = (unsigned)w;
+  *pHeight = (unsigned)h;
+  return p;
+}
+/**
+ *  Function to parse an XBM image in memory, the bits are converted in
+ *  place to the PBM order (left pixel in the MSB)
+ *  
+ * @return Pointer to the first image row or NULL on format error
+ */
+static const uint8_t *_lcd_image_xbm ( uint8_t *pFile, size_t len,
+  unsigned *pWidth, unsigned *pHeight )
+{
+  char *pText = (char *)pFile, *p;
+  uint8_t *pOut = pFile;
+  size_t need, n = 0;
+  long w, h;
+
+  pFile[len - 1] = '\0'; /* Room was kept for this by the loader */
+  p = strstr(pText, "_width");
+  if (p == NULL) return NULL;
+  w = strtol(p + 6, NULL, 10);
+  p = strstr(pText, "_height");
+  if (p == NULL) return NULL;
+  h = strtol(p + 7, NULL, 10);
+  p = strchr(pText, '{');
+  if (p == NULL || w <= 0 || h <= 0) return NULL;
+  need = (size_t)((w + 7) / 8) * (size_t)h;
+
+  /* The hex numbers are always longer than the bytes they give, so the
+     output can overwrite the text already read */
+  while (n < need)
+  {
+    char *pNext;
+    unsigned long v;
+    p = strstr(p, "0x");
+    if (p == NULL) return NULL;
+    v = strtoul(p, &pNext, 16);
+    p = pNext;
+    /* Reverse the bit order */
+    v = ((v & 0xF0) >> 4) | ((v & 0x0F) << 4);
+    v = ((v & 0xCC) >> 2) | ((v & 0x33) << 2);
+    v = ((v & 0xAA) >> 1) | ((v & 0x55) << 1);
+    pOut[n++] = (uint8_t)v;
+  }
+  *pWidth = (unsigned)w;
+  *pHeight = (unsigned)h;
+  return pOut;
+}
+/**
+ * @brief Function to read a PBM (binary P4) or XBM image file in the
+ *    page layout of the LCD, with its top left corner at the top left
+ *    of the display. See @ref lcd_image_convert
+ * 
+ * @param sPath Image file
+ * @param pPages Output of 'pages' x ST7565_LCD_MAX_COLUMNS bytes
+ * @param pages Number of pages in the output
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -91 for error in reading the file
+ *        -92 if the file is not a PBM or XBM image
+ *        -93 if there is not enough memory
+ */
+int lcd_image_read ( const char *sPath, uint8_t *pPages, unsigned pages )
+{
+  const uint8_t *pImage;
+  uint8_t *pFile;
+  unsigned w = 0, h = 0;
+  size_t len;
+  FILE *f;
+
+  f = fopen(sPath, "rb");
+  if (f == NULL) return ST7565_LCD_ERR(-91);
+  pFile = malloc(ST7565_LCD_IMAGE_MAXFILE + 1);
+  if (pFile == NULL)
+  {
+    fclose(f);
+    return ST7565_LCD_ERR(-93);
+  }
+  len = fread(pFile, 1, ST7565_LCD_IMAGE_MAXFILE, f);
+  fclose(f);
+
+  pImage = _lcd_image_pbm(pFile, len, &w, &h);
+  if (pImage == NULL && len > 0)
+  {
+    pImage = _lcd_image_xbm(pFile, len + 1, &w, &h);
+  }
+  if (pImage == NULL)
+  {
+    free(pFile);
+    return ST7565_LCD_ERR(-92);
+  }
+
+  lcd_image_convert(pImage, w, h, (w + 7) / 8, pPages, pages);
+  free(pFile);
+  return 0;
+}
+/**
+ * @brief Function to load a PBM (binary P4) or XBM image file into the
+ *    Shadow Frame Buffer (the Canvas in portrait), with its top left
+ *    corner at the top left of the display. Use @ref lcd_flush to send
+ *    it out.
+ * 
+ * @param sPath Image file
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        Else the Status of @ref lcd_image_read
+ */
+int lcd_image_load ( const char *sPath )
+{
+  uint8_t pages[ST7565_LCD_CANVAS_ROWS][ST7565_LCD_MAX_COLUMNS];
+  unsigned r, rows = ST7565_LCD_FB_HEIGHT / 8;
+  int retcode;
+
+  retcode = lcd_image_read(sPath, &pages[0][0], rows);
+  if (retcode != 0) return retcode;
+  if (ST7565_LCD_PORTRAIT)
+  {
+    /* Onto the Canvas */
+    lcd_fb_blit(0, 0, &pages[0][0], ST7565_LCD_MAX_COLUMNS, rows, 
+      ST7565_LCD_BLIT_COPY);
+    return 0;
+  }
+  for (r = 0; r < rows; r++)
+  {
+    lcd_fb_write(0, (uint8_t)r, pages[r], ST7565_LCD_MAX_COLUMNS);
+  }
+  return 0;
+}
+
+/************************************************************************/
+/* Update Planner                                                       */
+/************************************************************************/
+
+/*
+  Sends the difference between the Shadow (what the LCD shows) and a
+  new frame in the least bus time.
+  - Each page is cut into the runs of changed columns. To get from one
+    run to the next the controller can be addressed again (A0 low, the
+    page and the column nibbles that differ, A0 high), or the unchanged
+    columns between them can be sent along. Which one is cheaper depends
+    on the gap, the nibbles and the transport, so a dynamic-programming
+    pass over the runs picks the segments of each page:
+      best[i] = min over j <= i of best[j - 1] + segment(run j .. run i)
+    A segment costs the addressing from where the segment before it left
+    the controller, the transfer setup and its data bytes.
+  - The bus times are the Defaults for the SPI clock until measured on
+    the transport in use with @ref lcd_plan_calibrate ('lcd plan
+    calibrate', kept by the daemon).
+  - The whole frame is planned first and then sent back to back.
+*/
+
+/* Most runs of changed columns in a page - every other column */
+#define ST7565_LCD_PLAN_RUNS                 (ST7565_LCD_MAX_COLUMNS / 2)
+/* Most segments of a frame */
+#define ST7565_LCD_PLAN_SEGS   (ST7565_LCD_MAX_ROWS * ST7565_LCD_PLAN_RUNS)
+/* Calls timed for each part by lcd_plan_calibrate */
+#define ST7565_LCD_PLAN_CALLS                64U
+
+/* Segment of a plan - columns [lo, hi) of a text row */
+typedef struct
+{
+  uint8_t row;
+  uint8_t lo;
+  uint8_t hi;
+} lcd_plan_seg_t;
+
+/**
+ *  Function to get the controller column of a display column
+ */
+static uint8_t _lcd_plan_column ( unsigned bColumn )
+{
+  return gp_lcd->column_lut[bColumn];
+}
+/**
+ *  Function to get the bus time of one segment: the addressing that
+ *  @ref lcd_goto sends from the given controller page / column and the
+ *  data transfer of 'len' columns
+ */
+static uint32_t _lcd_plan_segment ( uint8_t bPage, uint8_t bColumn,
+  uint8_t bHwPage, uint8_t bHwColumn, unsigned len )
+{
+  const lcd_plan_cost_t *pCost = &gp_lcd->cost;
+  uint32_t ns = pCost->transfer + (uint32_t)len * pCost->data_byte;
+  unsigned n = (bHwPage != bPage);
+  if (bHwColumn == ST7565_LCD_STATE_UNKNOWN) n += 2;
+  else
+  {
+    n += ((bHwColumn ^ bColumn) & 0x0F) != 0;
+    n += ((bHwColumn ^ bColumn) & 0xF0) != 0;
+  }
+  if (n == 0) return ns; /* Carries on where the controller is */
+  return ns + 2 * pCost->a0 + pCost->transfer + n * pCost->cmd_byte;
+}
+/**
+ *  Function to plan one page - the segments go to pSeg, the controller
+ *  position is followed in pHwPage / pHwColumn
+ * 
+ * @return Number of segments
+ */
+static unsigned _lcd_plan_page ( uint8_t bRow, const uint8_t *pNew,
+  lcd_plan_seg_t *pSeg, uint8_t *pHwPage, uint8_t *pHwColumn )
+{
+  const uint8_t *pOld = gp_lcd->fb.data[bRow];
+  uint8_t lo[ST7565_LCD_PLAN_RUNS], hi[ST7565_LCD_PLAN_RUNS];
+  uint32_t best[ST7565_LCD_PLAN_RUNS + 1];
+  uint8_t from[ST7565_LCD_PLAN_RUNS + 1];
+  uint8_t page = _lcd_page(bRow);
+  /* Columns not yet flushed are not on the LCD - always sent */
+  unsigned dlo = gp_lcd->fb.dirty_lo[bRow], dhi = gp_lcd->fb.dirty_hi[bRow];
+  unsigned x = 0, n = 0, i, j, count;
+
+  /* Runs of changed columns */
+  while (x < ST7565_LCD_MAX_COLUMNS)
+  {
+    while (x < ST7565_LCD_MAX_COLUMNS && pNew[x] == pOld[x] && 
+      (x < dlo || x >= dhi)) x++;
+    if (x >= ST7565_LCD_MAX_COLUMNS) break;
+    lo[n] = (uint8_t)x;
+    while (x < ST7565_LCD_MAX_COLUMNS && (pNew[x] != pOld[x] ||
+      (x >= dlo && x < dhi))) x++;
+    hi[n++] = (uint8_t)x;
+  }
+  if (n == 0) return 0;
+
+  /* Cheapest segments ending with each run */
+  best[0] = 0;
+  for (i = 1; i <= n; i++)
+  {
+    best[i] = UINT32_MAX;
+    for (j = i; j >= 1; j--)
+    {
+      uint32_t data = (uint32_t)(hi[i - 1] - lo[j - 1]) * 
+        gp_lcd->cost.data_byte;
+      uint32_t ns;
+      /* Longer segments only add data from here on */
+      if (data >= best[i]) break;
+      ns = best[j - 1] + _lcd_plan_segment(page, _lcd_plan_column(lo[j - 1]),
+        (j == 1) ? *pHwPage : page,
+        (j == 1) ? *pHwColumn : _lcd_plan_column(hi[j - 2]),
+        hi[i - 1] - lo[j - 1]);
+      if (ns < best[i])
+      {
+        best[i] = ns;
+        from[i] = (uint8_t)j;
+      }
+    }
+  }
+
+  /* Segments back from the last run */
+  count = 0;
+  for (i = n; i > 0; i = from[i] - 1U) count++;
+  j = count;
+  for (i = n; i > 0; i = from[i] - 1U)
+  {
+    --j;
+    pSeg[j].row = bRow;
+    pSeg[j].lo = lo[from[i] - 1];
+    pSeg[j].hi = hi[i - 1];
+  }
+  *pHwPage = page;
+  *pHwColumn = _lcd_plan_column(hi[n - 1]);
+  gp_lcd->stats.plan_ns += best[n];
+  return count;
+}
+/**
+ *  Function to plan and send a frame - the cursor is left at the end of
+ *  the last segment
+ */
+static int _lcd_plan_send ( const uint8_t *pFrame )
+{
+  lcd_plan_seg_t seg[ST7565_LCD_PLAN_SEGS];
+  uint8_t hwpage = gp_lcd->hw_page, hwcolumn = gp_lcd->hw_column;
+  unsigned n = 0, i;
+  uint8_t r;
+  int retcode = 0;
+
+  for (r = 0; r < ST7565_LCD_MAX_ROWS; r++)
+  {
+    n += _lcd_plan_page(r, &pFrame[r * ST7565_LCD_MAX_COLUMNS], &seg[n],
+      &hwpage, &hwcolumn);
+  }
+  gp_lcd->stats.plan_segments += n;
+  for (i = 0; i < n && retcode == 0; i++)
+  {
+    retcode = lcd_goto(seg[i].lo, seg[i].row);
+    if (retcode == 0) retcode = lcd_data_buf(
+      &pFrame[seg[i].row * ST7565_LCD_MAX_COLUMNS + seg[i].lo], 
+      (size_t)(seg[i].hi - seg[i].lo));
+    /* The page is on the LCD once its last segment is sent */
+    if (retcode == 0 && (i + 1 == n || seg[i + 1].row != seg[i].row) &&
+      !gp_lcd->fb.deferred)
+    {
+      gp_lcd->fb.dirty_hi[seg[i].row] = 0;
+    }
+  }
+  return retcode;
+}
+/**
+ * @brief Function to show a complete frame - only the columns that differ
+ *    from the Shadow are sent, in the segments of least bus time
+ *    Need initialization of LCD @ref lcd_init before using this function
+ *    The cursor location is preserved.
+ * 
+ * @param pFrame ST7565_LCD_MAX_ROWS pages of ST7565_LCD_MAX_COLUMNS bytes
+ *    in the layout of the Shadow Frame Buffer
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        Else the Status of @ref lcd_goto or @ref lcd_data_buf
+ */
+int lcd_frame ( const uint8_t *pFrame )
+{
+  uint16_t row = gp_lcd->row, column = gp_lcd->column;
+  uint16_t fbrow = gp_lcd->fb.row, fbcolumn = gp_lcd->fb.column;
+  int retcode = _lcd_plan_send(pFrame);
+
+  if (fbrow < ST7565_LCD_FB_ROWS && fbcolumn < ST7565_LCD_MAX_COLUMNS)
+  {
+    lcd_goto((uint8_t)fbcolumn, (uint8_t)fbrow);
+  }
+  gp_lcd->row = row;
+  gp_lcd->column = column;
+  gp_lcd->fb.row = fbrow;
+  gp_lcd->fb.column = fbcolumn;
+  return retcode;
+}
+/**
+ *  Function to get the mean time of 'calls' runs of one part in ns
+ */
+static uint32_t _lcd_plan_mean ( const struct timespec *pT0, unsigned calls )
+{
+  struct timespec t1;
+  uint64_t ns;
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  ns = (uint64_t)(t1.tv_sec - pT0->tv_sec) * 1000000000ULL + 
+    (uint64_t)(t1.tv_nsec - pT0->tv_nsec);
+  return (uint32_t)(ns / calls);
+}
+/**
+ * @brief Function to measure the bus times of the Update Planner on the
+ *    transport in use
+ *    Need initialization of LCD @ref lcd_init before using this function
+ *    - Command transfers of 1 and 16 NOP give the byte and setup time
+ *    - Data transfers of 1 and 128 columns, rewriting what the Shadow
+ *      has for the top row, give the data byte time. Skipped (the same as
+ *      a command byte) while the top row is dirty or writes are deferred,
+ *      as the Shadow is then not what the LCD shows.
+ *    - Toggles of the A0 line give its time
+ *    The driver statistics and the cursor location are preserved.
+ * 
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        Else the Status of @ref lcd_cmd_buf or @ref lcd_data_buf
+ */
+int lcd_plan_calibrate ( void )
+{
+  uint8_t nop[16];
+  lcd_stats_t stats = gp_lcd->stats;
+  uint16_t row = gp_lcd->row, column = gp_lcd->column;
+  uint16_t fbrow = gp_lcd->fb.row, fbcolumn = gp_lcd->fb.column;
+  uint32_t one, many, a0, data1, data128;
+  struct timespec t0;
+  unsigned i;
+  int retcode = 0;
+
+  memset(nop, ST7565_LCD_CMD_NOP, sizeof(nop));
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (i = 0; i < ST7565_LCD_PLAN_CALLS && retcode == 0; i++)
+    retcode = lcd_cmd_buf(nop, 1);
+  one = _lcd_plan_mean(&t0, ST7565_LCD_PLAN_CALLS);
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (i = 0; i < ST7565_LCD_PLAN_CALLS && retcode == 0; i++)
+    retcode = lcd_cmd_buf(nop, sizeof(nop));
+  many = _lcd_plan_mean(&t0, ST7565_LCD_PLAN_CALLS);
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (i = 0; i < ST7565_LCD_PLAN_CALLS && retcode == 0; i++)
+    retcode = _lcd_a0((uint8_t)(~i & 1)) ? ST7565_LCD_ERR(-42) : 0;
+  a0 = _lcd_plan_mean(&t0, ST7565_LCD_PLAN_CALLS);
+
+  if (retcode == 0)
+  {
+    gp_lcd->cost.cmd_byte = (many > one) ? 
+      (many - one) / (uint32_t)(sizeof(nop) - 1) : 0;
+    gp_lcd->cost.transfer = (one > gp_lcd->cost.cmd_byte) ? 
+      one - gp_lcd->cost.cmd_byte : 0;
+    gp_lcd->cost.a0 = a0;
+    gp_lcd->cost.data_byte = gp_lcd->cost.cmd_byte;
+
+    if (!gp_lcd->fb.deferred && gp_lcd->fb.dirty_hi[0] == 0)
+    {
+      /* Each timed alone - the addressing in between is not counted */
+      uint32_t *pMean[2] = { &data1, &data128 };
+      size_t len[2] = { 1, ST7565_LCD_MAX_COLUMNS };
+      unsigned k;
+      for (k = 0; k < 2 && retcode == 0; k++)
+      {
+        uint64_t ns = 0;
+        for (i = 0; i < ST7565_LCD_PLAN_CALLS && retcode == 0; i++)
+        {
+          lcd_goto(0, 0);
+          retcode = _lcd_a0(1) ? ST7565_LCD_ERR(-32) : 0;
+          clock_gettime(CLOCK_MONOTONIC, &t0);
+          if (retcode == 0) 
+            retcode = lcd_data_buf(gp_lcd->fb.data[0], len[k]);
+          ns += _lcd_plan_mean(&t0, 1);
+        }
+        *pMean[k] = (uint32_t)(ns / ST7565_LCD_PLAN_CALLS);
+      }
+      if (retcode == 0 && data128 > data1)
+      {
+        gp_lcd->cost.data_byte = (data128 - data1) / 
+          (uint32_t)(ST7565_LCD_MAX_COLUMNS - 1);
+      }
+    }
+  }
+
+  if (fbrow < ST7565_LCD_FB_ROWS && fbcolumn < ST7565_LCD_MAX_COLUMNS)
+  {
+    lcd_goto((uint8_t)fbcolumn, (uint8_t)fbrow);
+  }
+  gp_lcd->row = row;
+  gp_lcd->column = column;
+  gp_lcd->fb.row = fbrow;
+  gp_lcd->fb.column = fbcolumn;
+  gp_lcd->stats = stats;
+  return retcode;
+}
+
+/************************************************************************/
+/* Frame Streaming                                                      */
+/************************************************************************/
+
+/*
+  Raw frames are read from the standard input and shown one after the
+  other, Eg. for live graphs produced by another program.
+  - A frame is ST7565_LCD_STREAM_FRAME bytes in the page layout of the
+    LCD: 8 rows of 128 columns, top row first, the top pixel of each
+    column byte is the MSB (same as the Shadow Frame Buffer).
+  - Each frame is compared with the Shadow (what the LCD shows) and
+    only the changed columns are sent, as planned by the Update Planner.
+  - With a frame rate the frames are shown at fixed times. When the
+    producer is faster than the LCD the frames that are already
+    superseded by a complete newer frame are dropped (newest wins),
+    unless every frame is to be shown.
+*/
+
+/* Size of one streamed frame */
+#define ST7565_LCD_STREAM_FRAME  (ST7565_LCD_MAX_ROWS * ST7565_LCD_MAX_COLUMNS)
+
+/**
+ *  Function to read one complete frame from the standard input
+ *  
+ * @return 1 for a frame, 0 at the end of the input
+ */
+static int _lcd_stream_read ( uint8_t *pFrame )
+{
+  size_t have = 0;
+  ssize_t n;
+  while (have < ST7565_LCD_STREAM_FRAME)
+  {
+    n = read(STDIN_FILENO, &pFrame[have], ST7565_LCD_STREAM_FRAME - have);
+    if (n <= 0) return 0; /* A partial last frame is not shown */
+    have += (size_t)n;
+  }
+  return 1;
+}
+/**
+ *  Function to drop the frames superseded by a complete newer one
+ *  already waiting on the standard input
+ */
+static int _lcd_stream_latest ( uint8_t *pFrame )
+{
+  int pending;
+  while (ioctl(STDIN_FILENO, FIONREAD, &pending) == 0 &&
+    pending >= (int)ST7565_LCD_STREAM_FRAME)
+  {
+    if (!_lcd_stream_read(pFrame)) return 0;
+    ++gp_lcd->stats.stream_drops;
+  }
+  return 1;
+}
+/**
+ * @brief Function to show the raw frames arriving on the standard input
+ *    till it is closed
+ *    Need @ref init_io before using this function, the LCD is
+ *    initialized first.
+ * 
+ * @param fps Frames per second, 0 to show the frames as they come
+ * @param bAll 1 - Show every frame even if the LCD falls behind
+ *             0 - Skip to the newest complete frame
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        Else the Status of the LCD operations in case of error
+ */
+int lcd_stream ( unsigned fps, uint8_t bAll )
+{
+  uint8_t frame[ST7565_LCD_STREAM_FRAME];
+  struct timespec next;
+  long period = fps ? 1000000000L / (long)fps : 0;
+  int retcode;
+
+  retcode = lcd_init();
+  if (retcode != 0) return retcode;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  while (_lcd_stream_read(frame))
+  {
+    if (!bAll && !_lcd_stream_latest(frame)) break;
+    if (period)
+    {
+      /* Wait for the time of this frame */
+      struct timespec now;
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+      next.tv_nsec += period;
+      if (next.tv_nsec >= 1000000000L)
+      {
+        next.tv_nsec -= 1000000000L;
+        ++next.tv_sec;
+      }
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      if (now.tv_sec > next.tv_sec || 
+        (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec))
+      {
+        next = now; /* Fallen behind - do not try to catch up */
+      }
+      /* Newer frames may have come in while waiting */
+      if (!bAll && !_lcd_stream_latest(frame)) break;
+    }
+    retcode = _lcd_plan_send(frame);
+    if (retcode != 0) return retcode;
+    ++gp_lcd->stats.stream_frames;
+  }
+  return 0;
+}
+
+/************************************************************************/
+/* Animation                                                            */
+/************************************************************************/
+
+/*
+  Animation file - frames in the page layout of the LCD, made with
+  'lcd encode <dir> <file> [fps]' from a directory of PBM (or XBM)
+  frames (in name order) and shown with 'lcd play <file>'.
+  All numbers are little endian.
+
+  Header (16 bytes):
+    "L7A1"       Magic
+    uint16_t     Frame count
+    uint16_t     Frames per second
+    uint8_t      Pages per frame (8)
+    uint8_t      Columns per page - 1 (127)
+    uint8_t      reserved[6]
+
+  Frame (8 byte header + payload):
+    uint8_t      Type 'K' - Key frame, 'D' - Delta to the previous frame
+    uint8_t      reserved
+    uint16_t     Duration in ms (0 - use the frames per second)
+    uint32_t     Payload size
+    Key frame    Every page as PackBits of its 128 columns
+    Delta frame  uint8_t mask of the changed pages, then for each of
+                 these: uint8_t first column, uint8_t column count - 1
+                 and the PackBits of the changed columns
+
+  PackBits: a header byte n, 0 - 127 is followed by n + 1 bytes as is,
+  129 - 255 by one byte repeated 257 - n times (128 is not used).
+  The player maps the file and decodes each frame into a work frame,
+  then sends the changed column runs like @ref lcd_stream. A Key frame
+  is sent completely as the LCD may not show what the Shadow holds.
+*/
+
+#define ST7565_LCD_ANIM_MAGIC                "L7A1"
+#define ST7565_LCD_ANIM_HEADER               16
+#define ST7565_LCD_ANIM_FRAMEHEADER          8
+/* Largest distance between two Key frames made by the encoder */
+#define ST7565_LCD_ANIM_KEYINTERVAL          32
+/* Default frames per second of the encoder */
+#define ST7565_LCD_ANIM_FPS                  10
+/* Largest PackBits of n bytes - Every literal but the last is followed
+   by a repeat of 2 or more, so "x y y" adds 1 byte for each 3 */
+#define ST7565_LCD_ANIM_PACKED(n)            ((n) + ((n) + 2) / 3)
+/* Largest encoded frame - Page mask, then first column, count and
+   PackBits of each page */
+#define ST7565_LCD_ANIM_MAXFRAME \
+  (1 + ST7565_LCD_MAX_ROWS * (2 + \
+    ST7565_LCD_ANIM_PACKED(ST7565_LCD_MAX_COLUMNS)))
+
+/**
+ *  Function to PackBits encode a run of bytes
+ *  
+ * @return Number of bytes written to pOut, 0 if more than 'size'
+ */
+static size_t _lcd_anim_pack ( const uint8_t *pIn, size_t len, 
+  uint8_t *pOut, size_t size )
+{
+  size_t i = 0, o = 0, run, lit;
+  while (i < len)
+  {
+    /* Repeated bytes */
+    for (run = 1; i + run < len && run < 128 && pIn[i + run] == pIn[i]; )
+      run++;
+    if (run >= 2)
+    {
+      if (o + 2 > size) return 0;
+      pOut[o++] = (uint8_t)(257 - run);
+      pOut[o++] = pIn[i];
+      i += run;
+      continue;
+    }
+    /* Literal bytes till the next repeat of 2 or more */
+    for (lit = 1; i + lit < len && lit < 128; lit++)
+    {
+      if (i + lit + 1 < len && pIn[i + lit] == pIn[i + lit + 1]) break;
+    }
+    if (o + 1 + lit > size) return 0;
+    pOut[o++] = (uint8_t)(lit - 1);
+    memcpy(&pOut[o], &pIn[i], lit);
+    o += lit;
+    i += lit;
+  }
+  return o;
+}
+/**
+ *  Function to decode exactly 'len' bytes of PackBits
+ *  
+ * @return Input bytes used, 0 if the data is broken
+ */
+static size_t _lcd_anim_unpack ( const uint8_t *pIn, size_t avail,
+  uint8_t *pOut, size_t len )
+{
+  size_t i = 0, o = 0, n;
+  while (o < len)
+  {
+    if (i >= avail) return 0;
+    n = pIn[i++];
+    if (n < 128)
+    {
+      n += 1;
+      if (o + n > len || i + n > avail) return 0;
+      memcpy(&pOut[o], &pIn[i], n);
+      i += n;
+    }
+    else if (n > 128)
+    {
+      n = 257 - n;
+      if (o + n > len || i >= avail) return 0;
+      memset(&pOut[o], pIn[i++], n);
+    }
+    else continue;
+    o += n;
+  }
+  return i;
+}
+/**
+ *  Function to put a little endian number into a buffer
+ */
+static void _lcd_anim_put ( uint8_t *p, uint32_t v, unsigned bytes )
+{
+  while (bytes--)
+  {
+    *p++ = (uint8_t)v;
+    v >>= 8;
+  }
+}
+/**
+ *  Function to get a little endian number from a buffer
+ */
+static uint32_t _lcd_anim_get ( const uint8_t *p, unsigned bytes )
+{
+  uint32_t v = 0;
+  while (bytes--) v = (v << 8) | p[bytes];
+  return v;
+}
+/**
+ *  Function to pick the frame files of the encoder
+ */
+static int _lcd_anim_filter ( const struct dirent *pEntry )
+{
+  size_t n = strlen(pEntry->d_name);
+  return n > 4 && (strcmp(&pEntry->d_name[n - 4], ".pbm") == 0 ||
+    strcmp(&pEntry->d_name[n - 4], ".xbm") == 0);
+}
+/**
+ * @brief Function to build an Animation file from a directory of PBM
+ *    (or XBM) frames, taken in the order of their names
+ *    Does not need the LCD. The result is put into 'sReport' as
+ *    "frames N bytes N raw N ratio N.N".
+ * 
+ * @param sDir Directory of the frames
+ * @param sPath Animation file to write
+ * @param fps Frames per second, 0 for the Default
+ * @param sReport Output for the report
+ * @param size Size of the report output
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -123 if there are no frames in the directory
+ *        -124 for error in writing the file
+ *        -125 if a frame does not fit the encoder buffers
+ *        Else the Status of @ref lcd_image_read for a bad frame
+ */
+int lcd_anim_encode ( const char *sDir, const char *sPath, unsigned fps,
+  char *sReport, size_t size )
+{
+  uint8_t prev[ST7565_LCD_MAX_ROWS][ST7565_LCD_MAX_COLUMNS];
+  uint8_t cur[ST7565_LCD_MAX_ROWS][ST7565_LCD_MAX_COLUMNS];
+  uint8_t key[ST7565_LCD_ANIM_FRAMEHEADER + ST7565_LCD_ANIM_MAXFRAME];
+  uint8_t delta[ST7565_LCD_ANIM_FRAMEHEADER + ST7565_LCD_ANIM_MAXFRAME];
+  uint8_t header[ST7565_LCD_ANIM_HEADER] = {0};
+  struct dirent **ppList;
+  char name[4096];
+  unsigned long total = ST7565_LCD_ANIM_HEADER;
+  size_t nk, nd, lo, hi, r, n;
+  int count, i, retcode = 0;
+  FILE *f;
+
+  if (fps == 0) fps = ST7565_LCD_ANIM_FPS;
+  count = scandir(sDir, &ppList, _lcd_anim_filter, alphasort);
+  if (count <= 0) return ST7565_LCD_ERR(-123);
+  f = fopen(sPath, "wb");
+  if (f == NULL) retcode = ST7565_LCD_ERR(-124);
+
+  memcpy(header, ST7565_LCD_ANIM_MAGIC, 4);
+  _lcd_anim_put(&header[4], (uint32_t)count, 2);
+  _lcd_anim_put(&header[6], fps, 2);
+  header[8] = ST7565_LCD_MAX_ROWS;
+  header[9] = ST7565_LCD_MAX_COLUMNS - 1;
+  if (retcode == 0 && fwrite(header, 1, sizeof(header), f) != sizeof(header))
+    retcode = ST7565_LCD_ERR(-124);
+
+  for (i = 0; i < count && retcode == 0; i++)
+  {
+    snprintf(name, sizeof(name), "%s/%s", sDir, ppList[i]->d_name);
+    retcode = lcd_image_read(name, &cur[0][0], ST7565_LCD_MAX_ROWS);
+    if (retcode != 0) break;
+
+    /* Key frame - all the pages */
+    nk = ST7565_LCD_ANIM_FRAMEHEADER;
+    for (r = 0; r < ST7565_LCD_MAX_ROWS && retcode == 0; r++)
+    {
+      n = _lcd_anim_pack(cur[r], ST7565_LCD_MAX_COLUMNS, &key[nk],
+        sizeof(key) - nk);
+      if (n == 0) retcode = ST7565_LCD_ERR(-125);
+      nk += n;
+    }
+    key[0] = 'K';
+
+    /* Delta frame - the changed span of each page */
+    nd = ST7565_LCD_ANIM_FRAMEHEADER + 1;
+    delta[ST7565_LCD_ANIM_FRAMEHEADER] = 0;
+    for (r = 0; i > 0 && r < ST7565_LCD_MAX_ROWS && retcode == 0; r++)
+    {
+      for (lo = 0; lo < ST7565_LCD_MAX_COLUMNS && 
+        cur[r][lo] == prev[r][lo]; lo++)
+        ;
+      if (lo == ST7565_LCD_MAX_COLUMNS) continue;
+      for (hi = ST7565_LCD_MAX_COLUMNS; cur[r][hi - 1] == prev[r][hi - 1];)
+        hi--;
+      delta[ST7565_LCD_ANIM_FRAMEHEADER] |= (uint8_t)(1U << r);
+      delta[nd++] = (uint8_t)lo;
+      delta[nd++] = (uint8_t)(hi - lo - 1);
+      n = _lcd_anim_pack(&cur[r][lo], hi - lo, &delta[nd],
+        sizeof(delta) - nd);
+      if (n == 0) retcode = ST7565_LCD_ERR(-125);
+      nd += n;
+    }
+    delta[0] = 'D';
+    if (retcode != 0) break;
+
+    /* Delta only if it is smaller and not too far from a Key frame */
+    {
+      uint8_t *pOut = (i % ST7565_LCD_ANIM_KEYINTERVAL == 0 || nd >= nk) ?
+        key : delta;
+      n = (pOut == key) ? nk : nd;
+      pOut[1] = 0;
+      _lcd_anim_put(&pOut[2], 0, 2);
+      _lcd_anim_put(&pOut[4], (uint32_t)(n - ST7565_LCD_ANIM_FRAMEHEADER), 4);
+      if (fwrite(pOut, 1, n, f) != n) retcode = ST7565_LCD_ERR(-124);
+      total += n;
+    }
+    memcpy(prev, cur, sizeof(prev));
+  }
+
+  for (i = 0; i < count; i++) free(ppList[i]);
+  free(ppList);
+  if (f != NULL && fclose(f) != 0 && retcode == 0)
+  {
+    retcode = ST7565_LCD_ERR(-124);
+  }
+  if (retcode == 0)
+  {
+    unsigned long raw = (unsigned long)count * ST7565_LCD_STREAM_FRAME;
+    snprintf(sReport, size, "frames %d bytes %lu raw %lu ratio %.1f\n",
+      count, total, raw, (double)raw / (double)total);
+  }
+  return retcode;
+}
+/**
+ * @brief Function to play an Animation file
+ *    Need initialization of LCD @ref lcd_init before using this function
+ *    The file is memory mapped and each frame is decoded straight from
+ *    it. The cursor location is preserved.
+ * 
+ * @param sPath Animation file
+ * @param loops Number of times to play, at least once
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -121 for error in opening or mapping the file
+ *        -122 if the file is not a valid Animation
+ *        Else the Status of the LCD operations in case of error
+ */
+int lcd_anim_play ( const char *sPath, unsigned loops )
+{
+  uint8_t frame[ST7565_LCD_MAX_ROWS][ST7565_LCD_MAX_COLUMNS];
+  uint16_t row = gp_lcd->row, column = gp_lcd->column;
+  const uint8_t *pMap, *p, *pEnd;
+  struct timespec next;
+  struct stat st;
+  unsigned count, fps, i, r;
+  long ns;
+  int fd, retcode = 0;
+
+  fd = open(sPath, O_RDONLY);
+  if (fd < 0) return ST7565_LCD_ERR(-121);
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return ST7565_LCD_ERR(-121);
+  }
+  if (st.st_size < ST7565_LCD_ANIM_HEADER)
+  {
+    close(fd);
+    return ST7565_LCD_ERR(-122);
+  }
+  pMap = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (pMap == MAP_FAILED) return ST7565_LCD_ERR(-121);
+  pEnd = pMap + st.st_size;
+
+  count = _lcd_anim_get(&pMap[4], 2);
+  fps = _lcd_anim_get(&pMap[6], 2);
+  if (memcmp(pMap, ST7565_LCD_ANIM_MAGIC, 4) != 0 || fps == 0 ||
+    pMap[8] != ST7565_LCD_MAX_ROWS || pMap[9] != ST7565_LCD_MAX_COLUMNS - 1)
+  {
+    munmap((void *)pMap, (size_t)st.st_size);
+    return ST7565_LCD_ERR(-122);
+  }
+  madvise((void *)pMap, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+  if (loops == 0) loops = 1;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  while (loops-- && retcode == 0)
+  {
+    p = pMap + ST7565_LCD_ANIM_HEADER;
+    for (i = 0; i < count && retcode == 0; i++)
+    {
+      const uint8_t *pData;
+      size_t size, used;
+      uint8_t type, mask;
+
+      if (pEnd - p < ST7565_LCD_ANIM_FRAMEHEADER)
+      {
+        retcode = ST7565_LCD_ERR(-122);
+        break;
+      }
+      type = p[0];
+      ns = (long)_lcd_anim_get(&p[2], 2) * 1000000L;
+      if (ns == 0) ns = 1000000000L / (long)fps;
+      size = _lcd_anim_get(&p[4], 4);
+      pData = p + ST7565_LCD_ANIM_FRAMEHEADER;
+      if ((size_t)(pEnd - pData) < size || (type != 'K' && type != 'D') ||
+        (type == 'D' && i == 0) || size < 1)
+      {
+        retcode = ST7565_LCD_ERR(-122);
+        break;
+      }
+      p = pData + size;
+
+      /* Decode into the work frame */
+      mask = 0xFF;
+      if (type == 'K')
+      {
+        for (r = 0; r < ST7565_LCD_MAX_ROWS && retcode == 0; r++)
+        {
+          used = _lcd_anim_unpack(pData, (size_t)(p - pData), frame[r], 
+            ST7565_LCD_MAX_COLUMNS);
+          if (used == 0) retcode = ST7565_LCD_ERR(-122);
+          pData += used;
+        }
+      }
+      else
+      {
+        mask = *pData++;
+        for (r = 0; r < ST7565_LCD_MAX_ROWS && retcode == 0; r++)
+        {
+          unsigned lo, n;
+          if ((mask & (1U << r)) == 0) continue;
+          if (p - pData < 2)
+          {
+            retcode = ST7565_LCD_ERR(-122);
+            break;
+          }
+          lo = pData[0];
+          n = pData[1] + 1U;
+          pData += 2;
+          if (lo + n > ST7565_LCD_MAX_COLUMNS) 
+          {
+            retcode = ST7565_LCD_ERR(-122);
+            break;
+          }
+          used = _lcd_anim_unpack(pData, (size_t)(p - pData), 
+            &frame[r][lo], n);
+          if (used == 0) retcode = ST7565_LCD_ERR(-122);
+          pData += used;
+        }
+      }
+      if (retcode != 0) break;
+
+      /* Show it at its time */
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+      next.tv_nsec += ns;
+      while (next.tv_nsec >= 1000000000L)
+      {
+        next.tv_nsec -= 1000000000L;
+        ++next.tv_sec;
+      }
+      if (type == 'D')
+      {
+        /* The rows left out are the same as on the LCD */
+        retcode = _lcd_plan_send(&frame[0][0]);
+        continue;
+      }
+      for (r = 0; r < ST7565_LCD_MAX_ROWS && retcode == 0; r++)
+      {
+        retcode = lcd_goto(0, (uint8_t)r);
+        if (retcode == 0) 
+          retcode = lcd_data_buf(frame[r], ST7565_LCD_MAX_COLUMNS);
+      }
+    }
+  }
+
+  munmap((void *)pMap, (size_t)st.st_size);
+  lcd_goto((uint8_t)column, (uint8_t)row);
+  return retcode;
+}
+
+/************************************************************************/
+/* Grayscale                                                            */
+/************************************************************************/
+
+/*
+  Four gray levels on the 1 bit LCD by frame rate control (FRC): a pixel
+  of level L (0 white - 3 black) is black in L of every 3 frames, and
+  the frames follow each other fast enough for the eye to see the mean.
+  - The source is held as two bit planes in the page layout of the LCD,
+    a frame is made from them with a few bit operations per byte.
+  - The phase of the cycle is staggered along the diagonals (x + y), so
+    a third of the pixels of a gray area change in every frame instead
+    of all of them blinking together - much less flicker.
+  - A timer thread sends the frames at a steady rate: it sleeps with
+    clock_nanosleep till an absolute time, so the errors do not add up.
+    Each frame goes through the Update Planner and only the bytes that
+    differ from the one before are sent. A frame that misses its time
+    is counted and the thread does not try to catch up.
+  - While the thread runs the Display is its own, only the gray source
+    functions can be used - the other commands stop it first.
+  The cost of a frame is what limits the rate, 'lcd bench' times the
+  frames of a few gray bars ('gray').
+*/
+
+/* Frames of one gray cycle */
+#define ST7565_LCD_GRAY_PHASES               3U
+/* Default and highest frame rate */
+#define ST7565_LCD_GRAY_HZ                   150U
+#define ST7565_LCD_GRAY_MAXHZ                2000U
+
+/* Lines of a page black in a frame for the levels 1 and 2, by the slot
+   of its top line - (column + 2 x page + phase) % 3 */
+static const uint8_t gca_gray_one[ST7565_LCD_GRAY_PHASES] =
+  { 0x92, 0x24, 0x49 };
+static const uint8_t gca_gray_two[ST7565_LCD_GRAY_PHASES] =
+  { 0xDB, 0xB6, 0x6D };
+
+/**
+ *  Function to make and send one frame of the cycle
+ */
+static int _lcd_gray_show ( unsigned phase )
+{
+  uint8_t frame[ST7565_LCD_MAX_ROWS][ST7565_LCD_MAX_COLUMNS];
+  unsigned r, c, s;
+
+  pthread_mutex_lock(&gp_lcd->gray.lock);
+  for (r = 0; r < ST7565_LCD_MAX_ROWS; r++)
+  {
+    const uint8_t *pLo = gp_lcd->gray.lo[r], *pHi = gp_lcd->gray.hi[r];
+    s = (2 * r + phase) % ST7565_LCD_GRAY_PHASES;
+    for (c = 0; c < ST7565_LCD_MAX_COLUMNS; c++)
+    {
+      /* 3 - always, 2 - slots 0 and 1, 1 - slot 0 */
+      frame[r][c] = (uint8_t)((pHi[c] & (pLo[c] | gca_gray_two[s])) |
+        (pLo[c] & gca_gray_one[s]));
+      if (++s == ST7565_LCD_GRAY_PHASES) s = 0;
+    }
+  }
+  pthread_mutex_unlock(&gp_lcd->gray.lock);
+  return _lcd_plan_send(&frame[0][0]);
+}
+/**
+ *  Timer thread - shows the frames of the cycle one after the other
+ */
+static void *_lcd_gray_thread ( void *pArg )
+{
+  const long period = 1000000000L / (long)((lcd_t *)pArg)->gray.hz;
+  struct sched_param param;
+  struct timespec next, t0, t1;
+  unsigned phase = 0;
+  unsigned long ns;
+  int retcode;
+
+  lcd_select((lcd_t *)pArg);
+  /* Real time when allowed, so the frames keep their times under load */
+  memset(&param, 0, sizeof(param));
+  param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+  pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  while (!atomic_load(&gp_lcd->gray.stop))
+  {
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    retcode = _lcd_gray_show(phase);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (retcode != 0)
+    {
+      gp_lcd->gray.error = retcode;
+      break;
+    }
+    ns = (unsigned long)((t1.tv_sec - t0.tv_sec) * 1000000000L + 
+      (t1.tv_nsec - t0.tv_nsec));
+    gp_lcd->gray.busy_ns += ns;
+    if (ns > gp_lcd->gray.max_ns) gp_lcd->gray.max_ns = ns;
+    ++gp_lcd->gray.frames;
+    ++gp_lcd->stats.gray_frames;
+    if (++phase == ST7565_LCD_GRAY_PHASES) phase = 0;
+
+    /* Time of the next frame */
+    next.tv_nsec += period;
+    if (next.tv_nsec >= 1000000000L)
+    {
+      next.tv_nsec -= 1000000000L;
+      ++next.tv_sec;
+    }
+    if (t1.tv_sec > next.tv_sec || 
+      (t1.tv_sec == next.tv_sec && t1.tv_nsec > next.tv_nsec))
+    {
+      ++gp_lcd->gray.late;
+      ++gp_lcd->stats.gray_late;
+      next = t1; /* Fallen behind - do not try to catch up */
+      continue;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+  }
+  return NULL;
+}
+/**
+ * @brief Function to fill a rectangle of the gray source with a level
+ *    Can be used while the frames are shown, the parts outside the
+ *    display are clipped.
+ * 
+ * @param x Column of the left edge
+ * @param y Pixel line of the top edge
+ * @param w Width in pixels
+ * @param h Height in pixels
+ * @param level 0 (white) to 3 (black)
+ */
+void lcd_gray_fill_rect ( int x, int y, int w, int h, uint8_t level )
+{
+  int x1 = x + w, y1 = y + h, row, c;
+  uint8_t mask, lo, hi;
+
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 > (int)ST7565_LCD_MAX_COLUMNS) x1 = ST7565_LCD_MAX_COLUMNS;
+  if (y1 > (int)ST7565_LCD_PARAM_HEIGHT) y1 = ST7565_LCD_PARAM_HEIGHT;
+  if (x >= x1 || y >= y1) return;
+  if (level >= ST7565_LCD_GRAY_LEVELS) level = ST7565_LCD_GRAY_LEVELS - 1;
+
+  pthread_mutex_lock(&gp_lcd->gray.lock);
+  for (row = y / 8; row <= (y1 - 1) / 8; row++)
+  {
+    mask = 0xFF;
+    if (row == y / 8)        mask &= (uint8_t)(0xFF >> (y % 8));
+    if (row == (y1 - 1) / 8) mask &= (uint8_t)(0xFF << (7 - (y1 - 1) % 8));
+    lo = (level & 1) ? mask : 0;
+    hi = (level & 2) ? mask : 0;
+    for (c = x; c < x1; c++)
+    {
+      gp_lcd->gray.lo[row][c] = (uint8_t)((gp_lcd->gray.lo[row][c] & ~mask) |
+        lo);
+      gp_lcd->gray.hi[row][c] = (uint8_t)((gp_lcd->gray.hi[row][c] & ~mask) |
+        hi);
+    }
+  }
+  pthread_mutex_unlock(&gp_lcd->gray.lock);
+}
+/**
+ * @brief Function to load a PGM (binary P5) image file as the gray
+ *    source, with its top left corner at the top left of the display
+ *    The 256 shades are rounded to the 4 levels, the parts not covered
+ *    by the image are white. Can be used while the frames are shown.
+ * 
+ * @param sPath Image file
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -91 for error in reading the file
+ *        -92 if the file is not a PGM image with 8 bit samples
+ *        -93 if there is not enough memory
+ */
+int lcd_gray_load ( const char *sPath )
+{
+  /* The two bits of the levels as row major images */
+  uint8_t lo[ST7565_LCD_PARAM_HEIGHT][ST7565_LCD_MAX_COLUMNS / 8];
+  uint8_t hi[ST7565_LCD_PARAM_HEIGHT][ST7565_LCD_MAX_COLUMNS / 8];
+  const uint8_t *p, *pEnd;
+  uint8_t *pFile;
+  unsigned x, y, level;
+  int w, h, maxval;
+  size_t len;
+  FILE *f;
+
+  f = fopen(sPath, "rb");
+  if (f == NULL) return ST7565_LCD_ERR(-91);
+  pFile = malloc(ST7565_LCD_IMAGE_MAXFILE);
+  if (pFile == NULL)
+  {
+    fclose(f);
+    return ST7565_LCD_ERR(-93);
+  }
+  len = fread(pFile, 1, ST7565_LCD_IMAGE_MAXFILE, f);
+  fclose(f);
+
+  p = pFile + 2;
+  pEnd = pFile + len;
+  w = h = maxval = -1;
+  if (len > 2 && pFile[0] == 'P' && pFile[1] == '5')
+  {
+    w = _lcd_image_pbm_number(&p, pEnd);
+    h = _lcd_image_pbm_number(&p, pEnd);
+    maxval = _lcd_image_pbm_number(&p, pEnd);
+    ++p; /* Single white space before the data */
+  }
+  if (w <= 0 || h <= 0 || maxval <= 0 || maxval > 255 || p > pEnd ||
+    (size_t)(pEnd - p) < (size_t)w * (size_t)h)
+  {
+    free(pFile);
+    return ST7565_LCD_ERR(-92);
+  }
+
+  memset(lo, 0, sizeof(lo));
+  memset(hi, 0, sizeof(hi));
+  for (y = 0; y < (unsigned)h && y < ST7565_LCD_PARAM_HEIGHT; y++)
+  {
+    for (x = 0; x < (unsigned)w && x < ST7565_LCD_MAX_COLUMNS; x++)
+    {
+      /* White is the highest sample */
+      level = (3U * (unsigned)(maxval - p[y * (unsigned)w + x]) + 
+        (unsigned)maxval / 2) / (unsigned)maxval;
+      if (level & 1) lo[y][x / 8] |= (uint8_t)(0x80 >> (x % 8));
+      if (level & 2) hi[y][x / 8] |= (uint8_t)(0x80 >> (x % 8));
+    }
+  }
+  free(pFile);
+
+  pthread_mutex_lock(&gp_lcd->gray.lock);
+  lcd_image_convert(&lo[0][0], ST7565_LCD_MAX_COLUMNS, 
+    ST7565_LCD_PARAM_HEIGHT, ST7565_LCD_MAX_COLUMNS / 8, 
+    &gp_lcd->gray.lo[0][0], ST7565_LCD_MAX_ROWS);
+  lcd_image_convert(&hi[0][0], ST7565_LCD_MAX_COLUMNS, 
+    ST7565_LCD_PARAM_HEIGHT, ST7565_LCD_MAX_COLUMNS / 8, 
+    &gp_lcd->gray.hi[0][0], ST7565_LCD_MAX_ROWS);
+  pthread_mutex_unlock(&gp_lcd->gray.lock);
+  return 0;
+}
+/**
+ * @brief Function to start showing the gray source on the current
+ *    Display from the timer thread
+ *    Need initialization of LCD @ref lcd_init before using this function
+ * 
+ * @param hz Frames per second, 0 for ST7565_LCD_GRAY_HZ - a gray level
+ *        repeats every 3 frames
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -141 if the timer thread could not be started
+ *        -142 for a frame rate over ST7565_LCD_GRAY_MAXHZ
+ */
+int lcd_gray_start ( unsigned hz )
+{
+  if (hz == 0) hz = ST7565_LCD_GRAY_HZ;
+  if (hz > ST7565_LCD_GRAY_MAXHZ) return ST7565_LCD_ERR(-142);
+  _lcd_gray_halt();
+  gp_lcd->gray.hz = hz;
+  gp_lcd->gray.error = 0;
+  gp_lcd->gray.frames = 0;
+  gp_lcd->gray.late = 0;
+  gp_lcd->gray.busy_ns = 0;
+  gp_lcd->gray.max_ns = 0;
+  atomic_store(&gp_lcd->gray.stop, 0);
+  if (pthread_create(&gp_lcd->gray.thread, NULL, _lcd_gray_thread, gp_lcd))
+  {
+    return ST7565_LCD_ERR(-141);
+  }
+  gp_lcd->gray.running = 1;
+  return 0;
+}
+/**
+ * @brief Function to stop the timer thread, the last frame stays on
+ *    the LCD
  * 
  * @param None
- * @return Status code for the Operaiton
+ * @return Status code for the Operation
  *        0 for successful operation
- *        -24 and -25 for error in I/O operations
- *        Else the last operation @ref lcd_clear
+ *        Else the Status of the LCD writes that stopped the thread
  */
-int lcd_init()
+int lcd_gray_stop ( void )
 {
-  if(gpioWrite(LCD_A0, 0) != 0) return -24;
-  if(gpioWrite(LCD_nRST, 0) != 0) return -25;
-  /* Reset the LCD */
-  lcd_reset();
-   /* Send Commands */
-  lcd_cmd(ST7565_LCD_CMD_SET_BIAS_7); /* Setup 1/7th Bias Level */
-  lcd_cmd(ST7565_LCD_CMD_SET_ADC_NORMAL); /* ADC Select */
-  lcd_cmd(ST7565_LCD_CMD_SET_COM_NORMAL); /* SHL Select */
-  lcd_cmd(ST7565_LCD_CMD_SET_DISP_START_LINE); /* Initial Display Line */
-  /* Turn On voltage converter (VC=1, VR=0, VF=0) */
-  lcd_cmd(ST7565_LCD_CMD_SET_POWER_CONTROL | 0x4);
-  usleep(50000); /* wait for 50% rising */
-  /* Turn On voltage regulator (VC=1, VR=1, VF=0) */
-  lcd_cmd(ST7565_LCD_CMD_SET_POWER_CONTROL | 0x6);
-  usleep(50000);
-  /* Turn on voltage follower (VC=1, VR=1, VF=1) */
-  lcd_cmd(ST7565_LCD_CMD_SET_POWER_CONTROL | 0x7);
-  usleep(10000); /* Wait */
-  /* Set LCD operating voltage (regulator resistor, ref voltage resistor) */
-  lcd_cmd(ST7565_LCD_CMD_SET_RESISTOR_RATIO | 0x7);
-  lcd_cmd(ST7565_LCD_CMD_DISPLAY_ON);
-  lcd_cmd(ST7565_LCD_CMD_SET_ALLPTS_NORMAL);
-  lcd_bright(ST7565_LCD_PARAM_BRIGHTNESS);   
-  
-  /* Finally Clean up the LCD */
+  return _lcd_gray_halt();
+}
+
+/************************************************************************/
+/* Benchmark                                                            */
+/************************************************************************/
+
+/*
+  Timing of the hot paths of the driver on the transport in use - the
+  Simulated one gives the pure CPU cost, the real LCD adds the SPI.
+  A counting transport is put in front of it, so the SPI transactions
+  and bytes of each operation are known on any transport.
+  The result is printed as one JSON object:
+    {"transport":"sim","calls":2000,"ops":[
+      {"op":"clear","calls_per_s":..,"bytes_per_s":..,
+       "transfers_per_call":..,"bytes_per_call":..,
+       "p50_us":..,"p99_us":..,"max_us":..}, ...]}
+*/
+
+/* Default number of calls timed for each operation */
+#define ST7565_LCD_BENCH_CALLS               2000U
+
+typedef struct
+{
+  const lcd_transport_t *inner; /* Transport being measured */
+  unsigned long transfers;
+  unsigned long bytes;
+} lcd_bench_t;
+
+/* Global Benchmark state */
+static lcd_bench_t gs_bench;
+
+static int _lcd_bench_init ( void )
+{
+  return gs_bench.inner->init();
+}
+static void _lcd_bench_term ( void )
+{
+  gs_bench.inner->term();
+}
+static int _lcd_bench_open ( void )
+{
+  return gs_bench.inner->open();
+}
+static void _lcd_bench_close ( void )
+{
+  gs_bench.inner->close();
+}
+static int _lcd_bench_pin ( unsigned pin, unsigned level )
+{
+  return gs_bench.inner->pin(pin, level);
+}
+static int _lcd_bench_write ( const uint8_t *pData, size_t len )
+{
+  ++gs_bench.transfers;
+  gs_bench.bytes += len;
+  return gs_bench.inner->write(pData, len);
+}
+static void _lcd_bench_delay ( unsigned us )
+{
+  gs_bench.inner->delay(us);
+}
+
+static const lcd_transport_t gs_io_bench =
+{
+  "bench",
+  _lcd_bench_init,
+  _lcd_bench_term,
+  _lcd_bench_open,
+  _lcd_bench_close,
+  _lcd_bench_pin,
+  _lcd_bench_write,
+  _lcd_bench_delay,
+};
+
+/* Operations measured - 'i' is the call number */
+static void _lcd_bench_goto ( unsigned i )
+{
+  lcd_goto((uint8_t)((i * 37) % ST7565_LCD_MAX_COLUMNS), 
+    (uint8_t)(i & ST7565_LCD_MASK_ROWS));
+}
+static void _lcd_bench_putc ( unsigned i )
+{
+  lcd_putc((char)('A' + i % 26));
+}
+static void _lcd_bench_puts ( unsigned i )
+{
+  lcd_goto(0, (uint8_t)(i & ST7565_LCD_MASK_ROWS));
+  lcd_puts("The quick brown fox");
+}
+static void _lcd_bench_clear ( unsigned i )
+{
+  (void)i;
+  lcd_clear();
+}
+static void _lcd_bench_frame ( unsigned i )
+{
+  (void)i;
+  lcd_fb_invalidate();
+  lcd_flush();
+}
+static void _lcd_bench_text ( unsigned i )
+{
+  /* Small change somewhere on the screen, as for a clock */
+  lcd_fb_text((int)(i % 90), (int)(i % 56), (i & 1) ? "12:34" : "12:35",
+    ST7565_LCD_BLIT_COPY);
+  lcd_flush();
+}
+static void _lcd_bench_line ( unsigned i )
+{
+  lcd_fb_line((int)(i % 128), 0, (int)(127 - i % 128), 63, 
+    (uint8_t)(i % 3));
+  lcd_flush();
+}
+static void _lcd_bench_gray ( unsigned i )
+{
+  /* One Grayscale frame of bars of the four levels */
+  uint8_t level;
+  if (i == 0)
+  {
+    for (level = 0; level < ST7565_LCD_GRAY_LEVELS; level++)
+    {
+      lcd_gray_fill_rect(level * 32, 0, 32, ST7565_LCD_PARAM_HEIGHT, level);
+    }
+  }
+  _lcd_gray_show(i % ST7565_LCD_GRAY_PHASES);
+}
+
+typedef struct
+{
+  const char *name;
+  void (*run)(unsigned i);
+} lcd_bench_op_t;
+
+static const lcd_bench_op_t gca_bench_ops[] =
+{
+  { "goto",  _lcd_bench_goto  },
+  { "putc",  _lcd_bench_putc  },
+  { "puts",  _lcd_bench_puts  },
+  { "clear", _lcd_bench_clear },
+  { "frame", _lcd_bench_frame },
+  { "text",  _lcd_bench_text  },
+  { "line",  _lcd_bench_line  },
+  { "gray",  _lcd_bench_gray  },
+};
+
+/**
+ *  Function to get a monotonic time stamp in ns
+ */
+static uint64_t _lcd_bench_ns ( void )
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+static int _lcd_bench_cmp ( const void *pA, const void *pB )
+{
+  uint32_t a = *(const uint32_t *)pA, b = *(const uint32_t *)pB;
+  return (a > b) - (a < b);
+}
+/**
+ * @brief Function to time the hot paths of the driver and print the
+ *    results as JSON on the standard output
+ *    Need @ref init_io before using this function, the LCD is
+ *    initialized and left cleared.
+ * 
+ * @param calls Number of calls timed for each operation
+ * @return Status code for the Operation
+ *        0 for successful operation
+ *        -111 if there is not enough memory
+ *        Else the Status of @ref lcd_init
+ */
+int lcd_bench ( unsigned calls )
+{
+  uint32_t *pLat;
+  uint64_t t0, t1, total;
+  unsigned long transfers, bytes;
+  size_t k;
+  unsigned i;
+  int retcode;
+
+  if (calls == 0) calls = ST7565_LCD_BENCH_CALLS;
+  pLat = malloc(calls * sizeof(uint32_t));
+  if (pLat == NULL) return -111;
+  retcode = lcd_init();
+  if (retcode != 0)
+  {
+    free(pLat);
+    return retcode;
+  }
+
+  gs_bench.inner = gp_lcd->io;
+  gp_lcd->io = &gs_io_bench;
+  printf("{\"transport\":\"%s\",\"calls\":%u,\"ops\":[", 
+    gs_bench.inner->name, calls);
+  for (k = 0; k < sizeof(gca_bench_ops) / sizeof(gca_bench_ops[0]); k++)
+  {
+    lcd_clear();
+    gs_bench.transfers = 0;
+    gs_bench.bytes = 0;
+    total = 0;
+    for (i = 0; i < calls; i++)
+    {
+      t0 = _lcd_bench_ns();
+      gca_bench_ops[k].run(i);
+      t1 = _lcd_bench_ns();
+      pLat[i] = (uint32_t)(t1 - t0);
+      total += t1 - t0;
+    }
+    transfers = gs_bench.transfers;
+    bytes = gs_bench.bytes;
+    if (total == 0) total = 1;
+    qsort(pLat, calls, sizeof(uint32_t), _lcd_bench_cmp);
+    printf("%s\n  {\"op\":\"%s\",\"calls_per_s\":%.0f,\"bytes_per_s\":%.0f,"
+      "\"transfers_per_call\":%.2f,\"bytes_per_call\":%.1f,"
+      "\"p50_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}",
+      k ? "," : "", gca_bench_ops[k].name,
+      calls * 1e9 / (double)total, bytes * 1e9 / (double)total,
+      (double)transfers / calls, (double)bytes / calls,
+      pLat[calls / 2] / 1e3, pLat[(calls * 99ULL) / 100] / 1e3,
+      pLat[calls - 1] / 1e3);
+  }
+  printf("\n]}\n");
+  gp_lcd->io = gs_bench.inner;
+  free(pLat);
   return lcd_clear();
 }
+
+/************************************************************************/
+/* Command Processing                                                   */
+/************************************************************************/
+
+/* Return code of @ref lcd_command when the Usage text needs to be shown */
+#define ST7565_LCD_USAGE                     1
+
+/* Size of the text output of one command */
+#define ST7565_LCD_OUTPUT_SIZE               4096
+
+/* Text output of the current command - printed by @ref main or sent
+   back to the client by the Daemon */
+typedef struct
+{
+  char   text[ST7565_LCD_OUTPUT_SIZE];
+  size_t len;
+} lcd_output_t;
+
+static lcd_output_t gs_output;
+
+/**
+ *  Function to add formatted text to the command output, the text is
+ *  cut when the output is full
+ */
+static void _lcd_output ( const char *sFormat, ... )
+{
+  va_list ap;
+  int n;
+  if (gs_output.len >= sizeof(gs_output.text) - 1) return;
+  va_start(ap, sFormat);
+  n = vsnprintf(&gs_output.text[gs_output.len], 
+    sizeof(gs_output.text) - gs_output.len, sFormat, ap);
+  va_end(ap);
+  if (n > 0) gs_output.len += (size_t)n;
+  if (gs_output.len >= sizeof(gs_output.text))
+    gs_output.len = sizeof(gs_output.text) - 1;
+}
+/**
+ * @brief Function to put the Driver Statistics into the command output
+ *    One "name value" pair per line, the counters that are still zero
+ *    in the flush latency and the error lists are left out.
+ * 
+ * @param None
+ */
+static void lcd_stats ( void )
+{
+  unsigned k;
+  _lcd_output("display %d\n", (int)(gp_lcd - gs_lcd));
+  _lcd_output("transport %s\n", gp_lcd->io->name);
+  _lcd_output("cmd_transfers %lu\n", gp_lcd->stats.cmd_transfers);
+  _lcd_output("cmd_bytes %lu\n", gp_lcd->stats.cmd_bytes);
+  _lcd_output("data_transfers %lu\n", gp_lcd->stats.data_transfers);
+  _lcd_output("data_bytes %lu\n", gp_lcd->stats.data_bytes);
+  _lcd_output("a0_toggles %lu\n", gp_lcd->stats.a0_toggles);
+  _lcd_output("gpio_writes %lu\n", gp_lcd->stats.gpio_writes);
+  _lcd_output("gotos %lu\n", gp_lcd->stats.gotos);
+  _lcd_output("goto_cmds %lu\n", gp_lcd->stats.goto_cmds);
+  _lcd_output("flushes %lu\n", gp_lcd->stats.flushes);
+  _lcd_output("stream_frames %lu\n", gp_lcd->stats.stream_frames);
+  _lcd_output("stream_drops %lu\n", gp_lcd->stats.stream_drops);
+  _lcd_output("glyph_hits %lu\n", gp_lcd->stats.glyph_hits);
+  _lcd_output("glyph_misses %lu\n", gp_lcd->stats.glyph_misses);
+  _lcd_output("plan_segments %lu\n", gp_lcd->stats.plan_segments);
+  _lcd_output("plan_ns %lu\n", gp_lcd->stats.plan_ns);
+  _lcd_output("gray_frames %lu\n", gp_lcd->stats.gray_frames);
+  _lcd_output("gray_late %lu\n", gp_lcd->stats.gray_late);
+  for (k = 0; k < ST7565_LCD_STATS_BUCKETS; k++)
+  {
+    if (gp_lcd->stats.flush_us[k] == 0) continue;
+    if (k == ST7565_LCD_STATS_BUCKETS - 1)
+      _lcd_output("flush_us_ge_%lu %lu\n", 1UL << k, gp_lcd->stats.flush_us[k]);
+    else
+      _lcd_output("flush_us_lt_%lu %lu\n", 2UL << k, gp_lcd->stats.flush_us[k]);
+  }
+  for (k = 1; k < ST7565_LCD_STATS_ERRORS; k++)
+  {
+    if (gp_lcd->stats.errors[k] == 0) continue;
+    _lcd_output("error_%d %lu\n", -(int)k, gp_lcd->stats.errors[k]);
+  }
+}
+
+/**
+ * @brief Function to print the Usage help text
+ * 
+ * @param None
+ */
+static void lcd_usage ( void )
+{
+  /* Print the Help Text */
+  printf("\n  Grapics LCD driver for ST7565 based 128 x 64 B/W LCD ");
+  printf("\n ------------------------------------------------------\n");
+  printf("\n Usage: ");
+  printf("\n     sudo ./lcd init [cold] - Initialize the LCD, a warm start");
+  printf(" keeping the screen if it is still set up, 'cold' for the Reset");
+  printf("\n     sudo ./lcd c     - Clear the LCD screen");
+  printf("\n     sudo ./lcd g X Y - Set the LCD write ");
+  printf("location to X(Column) and Y(Row)");
+  printf("\n     sudo ./lcd w \"String\" - Used to Print a string on LCD ");
+  printf("\n     sudo ./lcd w -   - Print the standard input on LCD");
+  printf("\n     sudo ./lcd t X Y \"String\" - Print a string with its top");
+  printf(" left corner at pixel X(Column) and Y(Line)");
+  printf("\n     sudo ./lcd px X Y [C]   - Draw a pixel, C is the Color");
+  printf(" 1-Black (Default) 0-White 2-Invert");
+  printf("\n     sudo ./lcd line X0 Y0 X1 Y1 [C] - Draw a line");
+  printf("\n     sudo ./lcd rect X Y W H [C] - Draw a rectangle");
+  printf("\n     sudo ./lcd box X Y W H [C]  - Draw a filled rectangle");
+  printf("\n     sudo ./lcd circle X Y R [C] - Draw a circle");
+  printf("\n     sudo ./lcd poly X0 Y0 X1 Y1 X2 Y2 ... [C] - Fill a polygon");
+  printf("\n     sudo ./lcd font [N] - Select the text Font N (daemon),");
+  printf(" or list the Fonts and their heights");
+  printf("\n     sudo ./lcd fontfile file - Load a font file made by");
+  printf(" 'bdf2font -o' and select it (daemon)");
+  printf("\n     sudo ./lcd scroll N - Scroll the text up by N rows");
+  printf("\n     sudo ./lcd scroll on|off - New line on the last row");
+  printf(" scrolls (daemon) or wraps to the top");
+  printf("\n     sudo ./lcd async on|off - Queue the LCD transfers for");
+  printf(" an I/O thread (daemon)");
+  printf("\n     sudo ./lcd sync  - Wait for the queued transfers");
+  printf("\n     sudo ./lcd image file - Show a PBM (P4) or XBM image");
+  printf("\n     sudo ./lcd test  - Draw a pattern on the LCD at the");
+  printf(" current location ");
+  printf("\n     sudo ./lcd stats [reset] - Show (or clear) the I/O");
+  printf(" counters, set LCD_STATS=1 to show them on exit");
+  printf("\n     sudo ./lcd panel [name] - Show or change the Panel Profile,");
+  printf(" 'lcd init' sends its setup");
+  printf("\n     sudo ./lcd orient [0|90|180|270 [mirror]] - Show or turn");
+  printf(" the picture, 90 and 270 are portrait for the drawing");
+  printf("\n     sudo ./lcd plan [calibrate | C D A T] - Show, measure or");
+  printf(" set the bus times in ns of a command byte, data byte, A0");
+  printf(" change and transfer setup used to plan the frame updates");
+  printf("\n     sudo ./lcd gray file [FPS [N]] - Show a PGM image in 4");
+  printf(" gray levels for N seconds, else till 'lcd gray off' (via the");
+  printf(" daemon)");
+  printf("\n     sudo ./lcd play file [N] - Play an Animation file N times");
+  printf("\n     ./lcd encode dir file [FPS] - Make an Animation file from");
+  printf(" the PBM frames in a directory");
+  printf("\n     sudo ./lcd stream [FPS] [all] - Show 1024 byte raw frames");
+  printf(" from the standard input, 'all' shows every frame (not via");
+  printf(" the daemon)");
+  printf("\n     sudo ./lcd bench [N] - Time the driver operations N times");
+  printf(" each, the result is printed as JSON (not via the daemon)");
+  printf("\n     sudo ./lcd sleep  - Put LCD in Sleep mode ");
+  printf("\n     sudo ./lcd wakeup - Start the LCD from Sleep mode ");
+  printf("\n     ./lcd dump file.pbm - Save the Simulated LCD as an image");
+  printf(" (LCD_TRANSPORT=sim)");
+  printf("\n     sudo ./lcd -d N ... - Any of the above on Display N, 0");
+  printf(" on CE0 (Default) or 1 on CE1");
+  printf("\n     sudo ./lcd daemon - Keep the LCD open and serve the above");
+  printf(" commands on %s", ST7565_LCD_PARAM_SOCKET);
+  printf("\n");
+  printf("\n   Design by Boseji <prog.ic@live.in> \n\n");
+}
+
+/**
+ * @brief Function to perform one command on the LCD
+ *    Need @ref init_io before using this function
+ *    This is shared by the single shot command line and the daemon mode
+ * 
+ * @param argc Number of Arguments - including the program name
+ * @param argv Passed Argument values in an Array
+ * 
+ * @return Status of the command
+ *        0 for successful operation
+ *        -26 if there is no such Display for '-d N'
+ *        ST7565_LCD_USAGE if the command is not known
+ *        Else the error code of the operation
+ */
+int lcd_command ( int argc, char **argv )
+{
+  /* Display to work on - Eg. "lcd -d 1 w Hello" */
+  if(argc >= 3 && strcmp("-d", argv[1]) == 0)
+  {
+    lcd_t *pSelf = gp_lcd;
+    lcd_t *pLcd = lcd_display((unsigned)atoi(argv[2]));
+    int retcode = 0;
+    if(pLcd == NULL) return ST7565_LCD_ERR(-26);
+    lcd_select(pLcd);
+    /* Opened on the first use */
+    if(!gp_lcd->io_open) retcode = init_io();
+    if(retcode == 0)
+    {
+      argv[2] = argv[0];
+      retcode = lcd_command(argc - 2, &argv[2]);
+    }
+    lcd_select(pSelf);
+    return retcode;
+  }
+
+  /* The LCD is the Grayscale thread's while it runs - stopped for all
+     the other commands but the statistics */
+  if(argc < 2 || (strcmp("gray", argv[1]) != 0 && 
+    strcmp("stats", argv[1]) != 0))
+  {
+    lcd_gray_stop();
+  }
+
+  /* In case of bare minimum input or 'init' command */
+  if(argc == 1 || (argc >= 2 && (strcmp("init", argv[1]) == 0) ))
+  {
+    /* Initialize the LCD - 'init cold' always with the Reset */
+    if(argc >= 3 && strcmp("cold", argv[2]) == 0) return lcd_init_cold();
+    return lcd_init();
+  }
+  
+  if(strcmp("sleep", argv[1]) == 0)
+  {
+     /* Enter into Standby */
+    lcd_standby(0);
+    return 0;
+  }
+
+  if(strcmp("wakeup", argv[1]) == 0)
+  {
+    /* Exit into Standby */
+    lcd_standby(1);
+    return 0;
+  }
+
+  if(strcmp("c", argv[1]) == 0)
+  {
+    /* Clear the LCD */
+    return lcd_clear();
+  }
+
+  if((strcmp("g", argv[1]) == 0) && argc == 4)
+  {
+    uint8_t row,col;
+    col = (uint8_t) (atoi(argv[2]) & ST7565_LCD_MASK_COLUMNS);
+    row = (uint8_t) (atoi(argv[3]) & ST7565_LCD_MASK_ROWS);
+    /* Go the Specific LCD Location */
+    return lcd_goto(col, row);
+  }
+
+  if(strcmp("test", argv[1]) == 0)
+  {
+    uint8_t pattern[64 * 6];
+    int i;
+    /* Test pattern */
+    for(i=0;i<(int)sizeof(pattern);i+=2)
+    {
+      pattern[i] = 0x55;
+      pattern[i + 1] = 0xAA;
+    }
+    return lcd_data_buf(pattern, sizeof(pattern));
+  }
+
+  if((strcmp("t", argv[1]) == 0) && argc == 5)
+  {
+    /* Print text at a Pixel location */
+    lcd_fb_text(atoi(argv[2]), atoi(argv[3]), argv[4], ST7565_LCD_BLIT_COPY);
+    return lcd_flush();
+  }
+
+  if(strcmp("px", argv[1]) == 0 || strcmp("line", argv[1]) == 0 ||
+    strcmp("rect", argv[1]) == 0 || strcmp("box", argv[1]) == 0 ||
+    strcmp("circle", argv[1]) == 0 || strcmp("poly", argv[1]) == 0)
+  {
+    /* Drawing Primitives - Numbers followed by an optional Color */
+    int v[2 * ST7565_LCD_POLY_MAXNODES + 1] = {0};
+    int n = argc - 2, i, need;
+    uint8_t color = BLACK;
+    if(n > (int)(sizeof(v) / sizeof(v[0]))) return ST7565_LCD_USAGE;
+    for(i = 0; i < n; i++) v[i] = atoi(argv[2 + i]);
+    need = (argv[1][0] == 'p' && argv[1][1] == 'x') ? 2 :
+      (argv[1][0] == 'c') ? 3 : (argv[1][0] == 'p') ? (n & ~1) : 4;
+    if(n == need + 1) color = (uint8_t)v[need];
+    else if(n != need) return ST7565_LCD_USAGE;
+    switch(argv[1][0])
+    {
+    case 'l': lcd_fb_line(v[0], v[1], v[2], v[3], color); break;
+    case 'r': lcd_fb_rect(v[0], v[1], v[2], v[3], color); break;
+    case 'b': lcd_fb_fill_rect(v[0], v[1], v[2], v[3], color); break;
+    case 'c': lcd_fb_circle(v[0], v[1], v[2], color); break;
+    default:
+      if(need == 2) lcd_fb_pixel(v[0], v[1], color);
+      else
+      {
+        int x[ST7565_LCD_POLY_MAXNODES], y[ST7565_LCD_POLY_MAXNODES];
+        for(i = 0; i < need / 2; i++)
+        {
+          x[i] = v[2 * i];
+          y[i] = v[2 * i + 1];
+        }
+        int retcode = lcd_fb_fill_polygon(x, y, need / 2, color);
+        if(retcode != 0) return retcode;
+      }
+      break;
+    }
+    return lcd_flush();
+  }
+
+  if((strcmp("async", argv[1]) == 0) && argc == 3)
+  {
+    /* Queue the LCD transfers for the I/O thread */
+    return lcd_async(strcmp("on", argv[2]) == 0);
+  }
+
+  if(strcmp("sync", argv[1]) == 0)
+  {
+    /* Wait for the queued transfers */
+    return lcd_sync();
+  }
+
+  if((strcmp("fontfile", argv[1]) == 0) && argc == 3)
+  {
+    /* Load and use a font file */
+    int font = lcd_font_load(argv[2]);
+    return (font < 0) ? font : lcd_font((uint8_t)font);
+  }
+
+  if(strcmp("font", argv[1]) == 0)
+  {
+    size_t i;
+    if(argc == 3) return lcd_font((uint8_t)atoi(argv[2]));
+    /* List the Fonts - the current one marked */
+    for(i = 0; i < ST7565_LCD_FONTS; i++)
+    {
+      if(gpa_fonts[i]->pages == 0) continue; /* No font file loaded */
+      _lcd_output("%u %s %u%s\n", (unsigned)i, gpa_fonts[i]->name,
+        gpa_fonts[i]->pages * ST7565_LCD_PARAM_FONT_CHARHEIGHT,
+        (gpa_fonts[i] == gp_lcd->font) ? " *" : "");
+    }
+    return 0;
+  }
+
+  if((strcmp("scroll", argv[1]) == 0) && argc == 3)
+  {
+    /* Scroll the text rows or set the new line behaviour */
+    if(strcmp("on", argv[2]) == 0 || strcmp("off", argv[2]) == 0)
+    {
+      lcd_scroll_text(argv[2][1] == 'n');
+      return 0;
+    }
+    return lcd_scroll((uint8_t)(atoi(argv[2]) & 0x0F));
+  }
+
+  if((strcmp("image", argv[1]) == 0) && argc == 3)
+  {
+    /* Show an Image file */
+    int retcode = lcd_image_load(argv[2]);
+    if(retcode != 0) return retcode;
+    return lcd_flush();
+  }
+
+  if(strcmp("stats", argv[1]) == 0)
+  {
+    /* Show or clear the Driver Statistics */
+    if(argc >= 3 && strcmp("reset", argv[2]) == 0)
+      memset(&gp_lcd->stats, 0, sizeof(gp_lcd->stats));
+    else
+      lcd_stats();
+    return 0;
+  }
+
+  if(strcmp("panel", argv[1]) == 0)
+  {
+    /* Show or change the Panel Profile */
+    const lcd_panel_t *pPanel;
+    unsigned i;
+    if(argc == 3)
+    {
+      int retcode = lcd_panel(argv[2]);
+      if(retcode != 0) return retcode;
+    }
+    else if(argc != 2) return ST7565_LCD_USAGE;
+    pPanel = gp_lcd->panel;
+    _lcd_output("panel %s\ncolumns %u\npages %u\noffset %u\npage_map",
+      pPanel->name, pPanel->columns, pPanel->pages, pPanel->offset);
+    for(i = 0; i < ST7565_LCD_PANEL_PAGES; i++)
+      _lcd_output(" %u", pPanel->page_map[i]);
+    _lcd_output("\nbias %u\ncontrast %u\nadc %s\ncom %s\nratio %u\n",
+      pPanel->bias, pPanel->contrast, 
+      pPanel->adc_reverse ? "reverse" : "normal",
+      pPanel->com_reverse ? "reverse" : "normal", pPanel->ratio);
+    _lcd_output("rotate %u\nmirror %s\n", pPanel->rotate * 90U,
+      pPanel->mirror ? "on" : "off");
+    return 0;
+  }
+
+  if(strcmp("orient", argv[1]) == 0)
+  {
+    /* Show or change the Orientation */
+    if(argc == 4 && strcmp("mirror", argv[3]) != 0) return ST7565_LCD_USAGE;
+    if(argc == 3 || argc == 4)
+    {
+      int retcode = lcd_orient((uint16_t)atoi(argv[2]), argc == 4);
+      if(retcode != 0) return retcode;
+    }
+    else if(argc != 2) return ST7565_LCD_USAGE;
+    _lcd_output("rotate %u\nmirror %s\n", gp_lcd->rotate * 90U,
+      gp_lcd->mirror ? "on" : "off");
+    return 0;
+  }
+
+  if(strcmp("plan", argv[1]) == 0)
+  {
+    /* Show, measure or set the bus times of the Update Planner */
+    int retcode = 0;
+    if(argc == 3 && strcmp("calibrate", argv[2]) == 0)
+    {
+      retcode = lcd_plan_calibrate();
+    }
+    else if(argc == 6)
+    {
+      gp_lcd->cost.cmd_byte = (uint32_t)strtoul(argv[2], NULL, 0);
+      gp_lcd->cost.data_byte = (uint32_t)strtoul(argv[3], NULL, 0);
+      gp_lcd->cost.a0 = (uint32_t)strtoul(argv[4], NULL, 0);
+      gp_lcd->cost.transfer = (uint32_t)strtoul(argv[5], NULL, 0);
+    }
+    else if(argc != 2) return ST7565_LCD_USAGE;
+    _lcd_output("cmd_byte_ns %u\ndata_byte_ns %u\na0_ns %u\ntransfer_ns %u\n",
+      gp_lcd->cost.cmd_byte, gp_lcd->cost.data_byte, gp_lcd->cost.a0,
+      gp_lcd->cost.transfer);
+    return retcode;
+  }
+
+  if((strcmp("gray", argv[1]) == 0) && argc >= 3 && argc <= 5)
+  {
+    /* Show a PGM image in 4 gray levels for N seconds, or till 'gray
+       off' (with the Daemon) - then the frame times of the run */
+    int retcode;
+    if(strcmp("off", argv[2]) != 0)
+    {
+      retcode = lcd_gray_load(argv[2]);
+      if(retcode == 0) retcode = lcd_init();
+      if(retcode == 0)
+        retcode = lcd_gray_start((argc >= 4) ? (unsigned)atoi(argv[3]) : 0);
+      if(retcode != 0 || argc != 5) return retcode;
+      sleep((unsigned)atoi(argv[4]));
+    }
+    retcode = lcd_gray_stop();
+    _lcd_output("gray_frames %lu\ngray_late %lu\nframe_us_avg %lu\n"
+      "frame_us_max %lu\n", gp_lcd->gray.frames, gp_lcd->gray.late,
+      gp_lcd->gray.frames ? 
+        gp_lcd->gray.busy_ns / gp_lcd->gray.frames / 1000 : 0,
+      gp_lcd->gray.max_ns / 1000);
+    return retcode;
+  }
+
+  if((strcmp("play", argv[1]) == 0) && (argc == 3 || argc == 4))
+  {
+    /* Play an Animation file */
+    return lcd_anim_play(argv[2], (argc == 4) ? (unsigned)atoi(argv[3]) : 1);
+  }
+
+  if((strcmp("encode", argv[1]) == 0) && (argc == 4 || argc == 5))
+  {
+    /* Build an Animation file - the LCD is not used */
+    char report[128] = "";
+    int retcode = lcd_anim_encode(argv[2], argv[3], 
+      (argc == 5) ? (unsigned)atoi(argv[4]) : 0, report, sizeof(report));
+    _lcd_output("%s", report);
+    return retcode;
+  }
+
+  if(strcmp("stream", argv[1]) == 0)
+  {
+    /* Show the frames from the standard input */
+    unsigned long frames = gp_lcd->stats.stream_frames;
+    unsigned long drops = gp_lcd->stats.stream_drops;
+    int retcode = lcd_stream((argc >= 3) ? (unsigned)atoi(argv[2]) : 0,
+      (argc >= 4) && (strcmp("all", argv[3]) == 0));
+    _lcd_output("frames %lu dropped %lu\n", 
+      gp_lcd->stats.stream_frames - frames, gp_lcd->stats.stream_drops - drops);
+    return retcode;
+  }
+
+  if(strcmp("bench", argv[1]) == 0)
+  {
+    /* Time the driver on the current transport */
+    return lcd_bench((argc >= 3) ? (unsigned)atoi(argv[2]) : 0);
+  }
+
+  if((strcmp("dump", argv[1]) == 0) && argc == 3)
+  {
+    /* Save the Simulated LCD */
+    return lcd_sim_dump(argv[2]);
+  }
+
+  if((strcmp("w", argv[1]) == 0) && argc == 3)      
+  {
+    char buf[ST7565_LCD_OUTPUT_SIZE];
+    ssize_t n;
+    int retcode = 0;
+    /* Print text in the Current Location */
+    if(strcmp("-", argv[2]) != 0) return lcd_puts(argv[2]);
+    /* Text from the standard input, as it arrives */
+    while((n = read(STDIN_FILENO, buf, sizeof(buf))) > 0)
+    {
+      retcode |= lcd_write(buf, (size_t)n);
+    }
+    return retcode;
+  }
+
+  return ST7565_LCD_USAGE;
+}
+
+/************************************************************************/
+/* Daemon Mode                                                          */
+/************************************************************************/
+
+/*
+  In the daemon mode the process initializes the GPIO and SPI only once
+  and then keeps serving the commands arriving on a Unix domain socket.
+  The normal command line invocation becomes a thin client when the
+  daemon is running, so the existing scripts keep working.
+
+  Protocol (SOCK_SEQPACKET - one message per command):
+    Request - The arguments (without the program name) each terminated
+              by a '\0', Eg. "g\0" "0\0" "3\0"
+    Reply   - The int32_t return code of @ref lcd_command followed by
+              its text output, if any (Eg. 'stats')
+  The Daemon shows its Driver Statistics when it is stopped.
+*/
+
+/* Largest command message - Arguments with terminators */
+#define ST7565_LCD_DAEMON_MSGSIZE            4096
+/* Maximum number of Arguments in one command */
+#define ST7565_LCD_DAEMON_MAXARGS            16
+/* Maximum number of clients connected at the same time */
+#define ST7565_LCD_DAEMON_CLIENTS            8
+
+/* Daemon keeps running till this is cleared by a signal */
+static volatile sig_atomic_t gb_daemon_run = 0;
+
 /**
- * @brief Function to Put the LCD into Deep Sleep mode
- * 
- * @param None
+ *  Signal handler to stop the Daemon
  */
-void lcd_sleep ( void )
+static void _lcd_daemon_signal ( int signum )
 {
-  lcd_cmd(ST7565_LCD_CMD_SET_STATIC_OFF);
-  lcd_cmd(ST7565_LCD_CMD_DISPLAY_OFF);
-  lcd_cmd(ST7565_LCD_CMD_SET_ALLPTS_ON);
+  (void)signum;
+  gb_daemon_run = 0;
 }
 /**
- * @brief Function to bring back the LCD from Deep Sleep mode
- *    All display contents are cleared and need to reinitalize
- *    
- * @param None
+ *  Function to fill the socket address of the Daemon
  */
-void lcd_wakeup ( void )
+static void _lcd_daemon_addr ( struct sockaddr_un *pAddr )
 {
-  lcd_cmd(ST7565_LCD_CMD_INTERNAL_RESET);
-  lcd_bright(ST7565_LCD_PARAM_BRIGHTNESS);
-  lcd_cmd(ST7565_LCD_CMD_SET_ALLPTS_NORMAL);
-  lcd_cmd(ST7565_LCD_CMD_DISPLAY_ON);
-  lcd_cmd(ST7565_LCD_CMD_SET_STATIC_ON);
-  lcd_cmd(ST7565_LCD_CMD_SET_STATIC_REG | 0x03);
+  memset(pAddr, 0, sizeof(*pAddr));
+  pAddr->sun_family = AF_UNIX;
+  strncpy(pAddr->sun_path, ST7565_LCD_PARAM_SOCKET, 
+    sizeof(pAddr->sun_path) - 1);
 }
 /**
- * @brief Function to Put and wakup the LCD in Standby mode
- *      In this mode the display contents are not lost
- *      its only not visible
- * @param bWakeUp Used to decide that if we need to enter or exit standby
- *        0 - Enters into the Standby mode
- *        1 - Exits the Standby mode
+ *  Function to process one command message from a client
+ *  
+ * @return 0 to keep the client, -1 if the client has to be dropped
  */
-void lcd_standby ( uint8_t bWakeUp )
+static int _lcd_daemon_serve ( int fd )
 {
-  if (bWakeUp == 0)
-  { /* Enter standby mode */
-    lcd_cmd(ST7565_LCD_CMD_SET_STATIC_ON);
-    lcd_cmd(ST7565_LCD_CMD_SET_STATIC_REG | 0x03);
-    lcd_cmd(ST7565_LCD_CMD_DISPLAY_OFF);
-    lcd_cmd(ST7565_LCD_CMD_SET_ALLPTS_ON);
-  }
-  else
-  { /* Wake from standby */
-    lcd_cmd(ST7565_LCD_CMD_SET_ALLPTS_NORMAL);
-    lcd_cmd(ST7565_LCD_CMD_DISPLAY_ON);
+  char msg[ST7565_LCD_DAEMON_MSGSIZE + 1];
+  char *argv[ST7565_LCD_DAEMON_MAXARGS + 1];
+  char out[sizeof(int32_t) + ST7565_LCD_OUTPUT_SIZE];
+  int argc = 0;
+  int32_t reply;
+  ssize_t len, i;
+
+  len = recv(fd, msg, ST7565_LCD_DAEMON_MSGSIZE, 0);
+  if (len <= 0) return -1; /* Closed or Error */
+  msg[len] = '\0';
+
+  /* Split the Arguments - slot 0 is the program name */
+  argv[argc++] = "lcd";
+  for (i = 0; i < len && argc < ST7565_LCD_DAEMON_MAXARGS; )
+  {
+    argv[argc++] = &msg[i];
+    i += (ssize_t)strlen(&msg[i]) + 1;
   }
+  argv[argc] = NULL;
+
+  gs_output.len = 0;
+  reply = (argc > 1) ? lcd_command(argc, argv) : ST7565_LCD_USAGE;
+  memcpy(out, &reply, sizeof(reply));
+  memcpy(&out[sizeof(reply)], gs_output.text, gs_output.len);
+  len = (ssize_t)(sizeof(reply) + gs_output.len);
+  if (send(fd, out, (size_t)len, MSG_NOSIGNAL) != len)
+    return -1;
+  return 0;
 }
-static void _lcd_process_putc_newline ()
+/**
+ * @brief Function to run the Daemon till it is stopped by a signal
+ *    Need @ref init_io before using this function
+ * 
+ * @param None
+ * @return Status code for the Operation
+ *        0 for normal termination
+ *        -71 for error in creating the socket
+ *        -72 for error in binding the socket (Daemon already running ?)
+ */
+int lcd_daemon ( void )
 {
-  /* Increment and Set the Location of Cursor */
-  ++gw_row;
-  if (gw_row >= ST7565_LCD_MAX_ROWS) /* Check if we are at the edge of the Screen */
+  struct sockaddr_un addr;
+  struct sigaction sa;
+  struct pollfd fds[ST7565_LCD_DAEMON_CLIENTS + 1];
+  int nfds = 1, i;
+  int lfd;
+
+  lfd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+  if (lfd < 0) return -71;
+  _lcd_daemon_addr(&addr);
+  unlink(addr.sun_path); /* Stale socket of a previous instance */
+  if (bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+    listen(lfd, ST7565_LCD_DAEMON_CLIENTS) != 0)
   {
-    gw_row = 0;
+    close(lfd);
+    return -72;
   }
-  lcd_goto(0, gw_row);
-}
+  /* Allow the scripts to use the LCD without root privileges */
+  chmod(addr.sun_path, 0666);
 
-void lcd_putc ( char c )
-{
-  uint8_t data, i;
-  uint8_t *pFont;
-  unsigned uoffset;
+  gb_daemon_run = 1;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = _lcd_daemon_signal;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
 
-  data = (uint8_t) ((uint8_t) c & 0x7FU); /* Filter out the Higher Range */
-  /* Filter our the Lower Range */
-  if (data < ST7565_LCD_PARAM_FONT_CHAR_MINVAL)
+  fds[0].fd = lfd;
+  fds[0].events = POLLIN;
+  while (gb_daemon_run)
   {
-    if (data == '\n') /* process the New Line */
+    /* Timeout to check the Run flag periodically */
+    if (poll(fds, nfds, 500) <= 0) continue;
+
+    for (i = nfds - 1; i > 0; i--)
     {
-      _lcd_process_putc_newline();
+      if (fds[i].revents == 0) continue;
+      if ((fds[i].revents & POLLIN) == 0 || _lcd_daemon_serve(fds[i].fd) != 0)
+      {
+        /* Drop the Client */
+        close(fds[i].fd);
+        fds[i] = fds[--nfds];
+      }
     }
-    else if (data == ST7565_LCD_FMT_CURSOR)
+
+    if ((fds[0].revents & POLLIN) && nfds <= ST7565_LCD_DAEMON_CLIENTS)
     {
-      /* Put Cursor */
-      for (i = ST7565_LCD_PARAM_FONT_CHARWIDTH; i > 0 ; i--)
+      int cfd = accept(lfd, NULL, NULL);
+      if (cfd >= 0)
       {
-        lcd_data(0xFC);
+        fds[nfds].fd = cfd;
+        fds[nfds].events = POLLIN;
+        fds[nfds].revents = 0;
+        ++nfds;
       }
     }
-    return;
   }
 
-  /* Get the Cursor shift for the current character - Need to avoid broken character writes */
-  gw_column += ST7565_LCD_PARAM_FONT_CHARWIDTH;
-
-  /* Check if we have spilled over the boundary */
-  if (gw_column >= ST7565_LCD_MAX_COLUMNS) 
+  for (i = 1; i < nfds; i++)
   {
-    _lcd_process_putc_newline();
-    /* Still needed as the current character would be written that 
-       the new line first Place*/
-    gw_column += ST7565_LCD_PARAM_FONT_CHARWIDTH; 
+    close(fds[i].fd);
   }
+  close(lfd);
+  unlink(addr.sun_path);
+
+  /* Final Statistics for the log */
+  gs_output.len = 0;
+  lcd_stats();
+  fwrite(gs_output.text, 1, gs_output.len, stdout);
+  return 0;
+}
+/**
+ *  Function to get the full path of a file the Daemon writes - the file
+ *  is usually not there yet, so its directory is resolved
+ * 
+ * @return 0 if the path is taken, -1 if the directory is not found
+ */
+static int _lcd_client_outpath ( const char *sFile, char *pPath )
+{
+  const char *sBase = strrchr(sFile, '/');
+  char dir[PATH_MAX];
+  size_t len;
 
-  /* Compute the Font Offset - We need 16 bit offset for actual address 
-   computation so using a pointer as a 16bit storage */
-  uoffset = (unsigned) (((uint16_t)data - ST7565_LCD_PARAM_FONT_CHAR_MINVAL) * 
-    ST7565_LCD_PARAM_FONT_WIDTH);
+  if (sBase == NULL)
+  {
+    memcpy(dir, ".", 2);
+    sBase = sFile;
+  }
+  else
+  {
+    len = (sBase == sFile) ? 1 : (size_t)(sBase - sFile);
+    if (len >= sizeof(dir)) return -1;
+    memcpy(dir, sFile, len);
+    dir[len] = '\0';
+    sBase++;
+  }
+  if (*sBase == '\0' || realpath(dir, pPath) == NULL) return -1;
+  len = strlen(pPath);
+  if (len + strlen(sBase) + 2 > PATH_MAX) return -1;
+  if (pPath[len - 1] != '/') pPath[len++] = '/';
+  strcpy(&pPath[len], sBase);
+  return 0;
+}
+/**
+ * @brief Function to hand over the command to a running Daemon
+ * 
+ * @param argc Number of Arguments - including the program name
+ * @param argv Passed Argument values in an Array
+ * @param pRetcode Return code of the command performed by the Daemon
+ * 
+ * @return 0 if the command was performed by the Daemon
+ *        -1 if no Daemon is running, the command needs to be done here
+ */
+static int lcd_client ( int argc, char **argv, int *pRetcode )
+{
+  struct sockaddr_un addr;
+  char msg[ST7565_LCD_DAEMON_MSGSIZE];
+  char out[sizeof(int32_t) + ST7565_LCD_OUTPUT_SIZE];
+  char path[PATH_MAX];
+  size_t len = 0, n;
+  ssize_t got;
+  int32_t reply;
+  int fd, i;
+  /* The command follows the Display selection '-d N' */
+  int cmd = (argc >= 3 && strcmp("-d", argv[1]) == 0) ? 2 : 0;
 
-  /* Get the Font Pointer */
-  pFont =  (uint8_t *) ((uint8_t *)gca_font + uoffset);
+  /* Build the Message - No arguments means 'init' */
+  if (argc == 1)
+  {
+    memcpy(msg, "init", 5);
+    len = 5;
+  }
+  for (i = 1; i < argc; i++)
+  {
+    const char *sArg = argv[i];
+    /* Files are opened by the Daemon - from its own directory */
+    if (i == cmd + 2 && (strcmp("image", argv[cmd + 1]) == 0 ||
+      strcmp("play", argv[cmd + 1]) == 0 ||
+      strcmp("fontfile", argv[cmd + 1]) == 0 ||
+      (strcmp("gray", argv[cmd + 1]) == 0 && 
+      strcmp("off", argv[i]) != 0)) &&
+      realpath(argv[i], path) != NULL)
+    {
+      sArg = path;
+    }
+    else if (i == cmd + 2 && strcmp("dump", argv[cmd + 1]) == 0 &&
+      _lcd_client_outpath(argv[i], path) == 0)
+    {
+      sArg = path;
+    }
+    n = strlen(sArg) + 1;
+    if (len + n > sizeof(msg))
+    {
+      *pRetcode = -73;
+      return 0;
+    }
+    memcpy(&msg[len], sArg, n);
+    len += n;
+  }
 
-  /* Get the Font to Screen */
-  for (i = ST7565_LCD_PARAM_FONT_WIDTH; i > 0 ; i--, pFont++)
+  fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+  if (fd < 0) return -1;
+  _lcd_daemon_addr(&addr);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+  got = -1;
+  if (argc == cmd + 3 && strcmp("w", argv[cmd + 1]) == 0 &&
+    strcmp("-", argv[cmd + 2]) == 0)
+  {
+    /* Pass on the standard input in pieces - [-d N] "w\0" <text> "\0" */
+    const size_t p = len - 2;
+    ssize_t n;
+    int32_t first = 0;
+    got = sizeof(reply);
+    while ((n = read(STDIN_FILENO, &msg[p], sizeof(msg) - p - 1)) > 0)
+    {
+      /* Text can not carry the argument terminator */
+      ssize_t j, k = 0;
+      for (j = 0; j < n; j++)
+        if (msg[p + j] != '\0') msg[p + k++] = msg[p + j];
+      msg[p + k] = '\0';
+      got = -1;
+      if (send(fd, msg, p + (size_t)k + 1, MSG_NOSIGNAL) !=
+        (ssize_t)(p + (size_t)k + 1)) break;
+      got = recv(fd, out, sizeof(out), 0);
+      if (got < (ssize_t)sizeof(reply)) break;
+      memcpy(&reply, out, sizeof(reply));
+      if (first == 0) first = reply;
+    }
+    if (got >= (ssize_t)sizeof(reply))
+    {
+      /* First error of the pieces is the result */
+      memcpy(out, &first, sizeof(first));
+      got = sizeof(first);
+    }
+  }
+  else if (send(fd, msg, len, MSG_NOSIGNAL) == (ssize_t)len)
+  {
+    got = recv(fd, out, sizeof(out), 0);
+  }
+  if (got < (ssize_t)sizeof(reply))
   {
-    data = *pFont;
-    lcd_data(data);
+    reply = -74;
   }
-  /* For the Additional Char width to have spacing */
-  for (i = (ST7565_LCD_PARAM_FONT_CHARWIDTH - ST7565_LCD_PARAM_FONT_WIDTH); 
-    i > 0 ; i--)
+  else
   {
-    lcd_data(0x00);
+    /* Return code and the text output of the command */
+    memcpy(&reply, out, sizeof(reply));
+    fwrite(&out[sizeof(reply)], 1, (size_t)got - sizeof(reply), stdout);
   }
+  close(fd);
+  *pRetcode = reply;
+  return 0;
 }
 
 /************************************************************************/
@@ -860,8 +6749,58 @@ void lcd_putc ( char c )
 int main(int argc,char **argv)
 {
   int retcode = 0;
+  uint8_t daemon = (argc >= 2 && strcmp("daemon", argv[1]) == 0);
+  /* The command follows the Display selection '-d N' */
+  int cmd = (argc >= 3 && strcmp("-d", argv[1]) == 0) ? 2 : 0;
+  /* Benchmark and Streaming - always run in this process */
+  uint8_t local = daemon || (argc >= cmd + 2 &&
+    (strcmp("bench", argv[cmd + 1]) == 0 ||
+    strcmp("stream", argv[cmd + 1]) == 0));
+  unsigned i;
+
+  /* Commands that do not need the LCD */
+  if(argc >= 2 && strcmp("encode", argv[1]) == 0)
+  {
+    retcode = lcd_command(argc, argv);
+    if(retcode == ST7565_LCD_USAGE)
+    {
+      lcd_usage();
+      retcode = 0;
+    }
+    fwrite(gs_output.text, 1, gs_output.len, stdout);
+    if( retcode != 0 )
+      printf("\nError Code: %d\n", retcode);
+    return retcode;
+  }
+
+  /* Let the running Daemon do the work if there is one */
+  if(!local && lcd_client(argc, argv, &retcode) == 0)
+  {
+    if(retcode == ST7565_LCD_USAGE)
+    {
+      lcd_usage();
+      retcode = 0;
+    }
+    if( retcode != 0 )
+      printf("\nError Code: %d\n", retcode);
+    return retcode;
+  }
+
+  /* Pick the Transport if asked for - the same for all the Displays */
+  for(i = 0; i < ST7565_LCD_DISPLAYS && getenv("LCD_TRANSPORT") != NULL; i++)
+  {
+    lcd_select(lcd_display(i));
+    retcode = lcd_transport_select(getenv("LCD_TRANSPORT"));
+    if(retcode != 0)
+    {
+      printf("\nError Code: %d\n", retcode);
+      return retcode;
+    }
+  }
+  lcd_select(lcd_display(0));
+
   /* initialize the Driver */
-  if(gpioInitialise() < 0)
+  if(gp_lcd->io->init() < 0)
   {
       printf("\n ERROR: Could not initialize the GPIO \n");
       return -1;
@@ -873,99 +6812,36 @@ int main(int argc,char **argv)
     retcode = init_io();
     if(retcode != 0) break;
     
-    /* Based on Input Codes perform the Function */
-    
-    /* In case of bare minimum input or 'init' command */
-    if(argc == 1 || (argc >= 2 && (strcmp("init", argv[1]) == 0) ))
-    {
-      /* Initialize the LCD */
-      retcode = lcd_init();
-      break;
-    }
-    
-    if(strcmp("sleep", argv[1]) == 0)
-    {
-       /* Enter into Standby */
-      lcd_standby(0);
-      break;
-    }
-
-    if(strcmp("wakeup", argv[1]) == 0)
-    {
-      /* Exit into Standby */
-      lcd_standby(1);
-      break;
-    }
-
-    if(strcmp("c", argv[1]) == 0)
-    {
-      /* Clear the LCD */
-      retcode = lcd_clear();
-      break;
-    }
-
-    if((strcmp("g", argv[1]) == 0) && argc == 4)
-    {
-      uint8_t row,col;
-      col = (uint8_t) (atoi(argv[2]) & ST7565_LCD_MASK_COLUMNS);
-      row = (uint8_t) (atoi(argv[3]) & ST7565_LCD_MASK_ROWS);
-      /* Go the Specific LCD Location */
-      retcode = lcd_goto(col, row);
-      break;
-    }
-
-    if(strcmp("test", argv[1]) == 0)
+    if(daemon)
     {
-      int i;
-      /* Test pattern */
-      for(i=0;i<64;i++)
-      {
-        lcd_data(0x55);
-        lcd_data(0xAA);
-        lcd_data(0x55);
-        lcd_data(0xAA);
-        lcd_data(0x55);
-        lcd_data(0xAA);
-      }
+      /* Serve the commands till we are stopped */
+      retcode = lcd_daemon();
       break;
     }
 
-    if((strcmp("w", argv[1]) == 0) && argc == 3)      
+    /* Based on Input Codes perform the Function */
+    retcode = lcd_command(argc, argv);
+    fwrite(gs_output.text, 1, gs_output.len, stdout);
+    if(retcode == ST7565_LCD_USAGE)
     {
-      /* Print text in the Current Location */
-      int i;
-      for(i=0;argv[2][i]!=0;i++) /* Null Terminated String */
-      {
-        lcd_putc(argv[2][i]);
-      }
-      break;
+      lcd_usage();
+      retcode = 0;
     }
-    
-    /* Print the Help Text */
-    printf("\n  Grapics LCD driver for ST7565 based 128 x 64 B/W LCD ");
-    printf("\n ------------------------------------------------------\n");
-    printf("\n Usage: ");
-    printf("\n     sudo ./lcd init  - Initialize the LCD ");
-    printf("\n     sudo ./lcd c     - Clear the LCD screen");
-    printf("\n     sudo ./lcd g X Y - Set the LCD write ");
-    printf("location to X(Column) and Y(Row)");
-    printf("\n     sudo ./lcd w \"String\" - Used to Print a string on LCD ");
-    printf("\n     sudo ./lcd test  - Draw a pattern on the LCD at the");
-    printf(" current location ");
-    printf("\n     sudo ./lcd sleep  - Put LCD in Sleep mode ");
-    printf("\n     sudo ./lcd wakeup - Start the LCD from Sleep mode ");
-    printf("\n");
-    printf("\n   Design by Boseji <prog.ic@live.in> \n\n");
-    
-    
   }while(0);
-  /* Check if the SPI handle is open */
-  if(gx_spihandle >= 0)
+  /* Release the SPI and GPIO of all the Displays used */
+  for(i = ST7565_LCD_DISPLAYS; i-- > 0; )
+  {
+    lcd_select(lcd_display(i));
+    close_io();
+  }
+  if(!daemon && getenv("LCD_STATS") != NULL)
   {
-    gx_spihandle = spiClose(gx_spihandle);
+    gs_output.len = 0;
+    lcd_stats();
+    fwrite(gs_output.text, 1, gs_output.len, stdout);
   }
   /* Terminate the Driver */
-  gpioTerminate();
+  gp_lcd->io->term();
   /* In Error scenarios print the Last Return code*/
   if( retcode != 0 )
     printf("\nError Code: %d\n", retcode);
@@ -0,0 +1,90 @@
+/************************************************************************/
+/* Test of the Animation encoder and player                            */
+/************************************************************************/
+
+/*
+  Built with 'make test' on the Simulated LCD. The frames have the
+  "x y y" column pattern, the worst case of PackBits, which has to fit
+  the encoder buffers and play back as it was drawn.
+*/
+
+#define main lcd_main
+#include "../lcdST7565.c"
+#undef main
+
+static int gs_failed;
+
+#define CHECK(c) do { if (!(c)) { printf("FAIL %s:%d %s\n", __FILE__, \
+  __LINE__, #c); gs_failed = 1; } } while (0)
+
+/**
+ *  Function to write a PBM frame, black in each column c with
+ *  c % 3 == phase
+ */
+static int _test_frame ( const char *sPath, unsigned phase )
+{
+  uint8_t line[ST7565_LCD_MAX_COLUMNS / 8];
+  unsigned x, y;
+  FILE *f = fopen(sPath, "wb");
+  if (f == NULL) return -1;
+  fprintf(f, "P4\n%u %u\n", ST7565_LCD_MAX_COLUMNS, ST7565_LCD_PARAM_HEIGHT);
+  memset(line, 0, sizeof(line));
+  for (x = 0; x < ST7565_LCD_MAX_COLUMNS; x++)
+  {
+    if (x % 3 == phase) line[x / 8] |= (uint8_t)(0x80U >> (x % 8));
+  }
+  for (y = 0; y < ST7565_LCD_PARAM_HEIGHT; y++)
+    fwrite(line, 1, sizeof(line), f);
+  return fclose(f);
+}
+
+int main ( void )
+{
+  uint8_t page[ST7565_LCD_MAX_COLUMNS], back[ST7565_LCD_MAX_COLUMNS];
+  uint8_t out[ST7565_LCD_ANIM_PACKED(ST7565_LCD_MAX_COLUMNS) + 1];
+  uint8_t frame[ST7565_LCD_MAX_ROWS][ST7565_LCD_MAX_COLUMNS];
+  char sDir[] = "/tmp/lcdST7565-test-XXXXXX";
+  char sPath[128], sAnim[128], sReport[128];
+  size_t i, n;
+  unsigned f;
+
+  setenv("LCD_STATE", "", 1);
+
+  /* The worst case packs to the bound and not a byte less */
+  for (i = 0; i < sizeof(page); i++) page[i] = (i % 3 == 0) ? 0xFF : 0x00;
+  n = _lcd_anim_pack(page, sizeof(page), out, sizeof(out));
+  CHECK(n == ST7565_LCD_ANIM_PACKED(sizeof(page)));
+  CHECK(_lcd_anim_unpack(out, n, back, sizeof(back)) == n);
+  CHECK(memcmp(page, back, sizeof(page)) == 0);
+  CHECK(_lcd_anim_pack(page, sizeof(page), out, n - 1) == 0);
+
+  /* Encode a Key frame and a Delta frame of the pattern */
+  if (mkdtemp(sDir) == NULL) return 1;
+  for (f = 0; f < 2; f++)
+  {
+    snprintf(sPath, sizeof(sPath), "%s/%u.pbm", sDir, f);
+    CHECK(_test_frame(sPath, f) == 0);
+  }
+  snprintf(sAnim, sizeof(sAnim), "%s/anim", sDir);
+  CHECK(lcd_anim_encode(sDir, sAnim, 100, sReport, sizeof(sReport)) == 0);
+
+  /* Played back, the LCD holds the last frame */
+  CHECK(gp_lcd->io->init() == 0);
+  CHECK(init_io() == 0);
+  CHECK(lcd_init() == 0);
+  CHECK(lcd_anim_play(sAnim, 1) == 0);
+  CHECK(lcd_image_read(sPath, &frame[0][0], ST7565_LCD_MAX_ROWS) == 0);
+  CHECK(memcmp(gp_lcd->fb.data, frame, sizeof(frame)) == 0);
+  close_io();
+  gp_lcd->io->term();
+
+  for (f = 0; f < 2; f++)
+  {
+    snprintf(sPath, sizeof(sPath), "%s/%u.pbm", sDir, f);
+    unlink(sPath);
+  }
+  unlink(sAnim);
+  rmdir(sDir);
+  printf("%s anim\n", gs_failed ? "FAIL" : "ok");
+  return gs_failed;
+}
@@ -0,0 +1,91 @@
+/************************************************************************/
+/* Test of the Bitmap Import                                            */
+/************************************************************************/
+
+/*
+  Built with 'make test' twice - with the SSE2 kernel where the build
+  machine has it, and with ST7565_NO_SSE2 for the portable kernel. PBM
+  files of a known pattern are read with lcd_image_read and compared
+  with a conversion done pixel by pixel.
+*/
+
+#define main lcd_main
+#include "../lcdST7565.c"
+#undef main
+
+static int gs_failed;
+
+#define CHECK(c) do { if (!(c)) { printf("FAIL %s:%d %s\n", __FILE__, \
+  __LINE__, #c); gs_failed = 1; } } while (0)
+
+/**
+ *  Function to write a PBM of a fixed pseudo random pattern, kept in
+ *  pImage as well
+ */
+static int _test_pbm ( const char *sPath, unsigned width, unsigned height,
+  uint8_t *pImage )
+{
+  uint32_t seed = 0x2545F491U;
+  size_t i, len = (size_t)(width + 7) / 8 * height;
+  FILE *f = fopen(sPath, "wb");
+  if (f == NULL) return -1;
+  for (i = 0; i < len; i++)
+  {
+    seed = seed * 1103515245U + 12345U;
+    pImage[i] = (uint8_t)(seed >> 16);
+  }
+  fprintf(f, "P4\n%u %u\n", width, height);
+  fwrite(pImage, 1, len, f);
+  return fclose(f);
+}
+
+/**
+ *  Function to read an image of the pattern and check every pixel of
+ *  the pages
+ */
+static void _test_image ( const char *sPath, unsigned width, 
+  unsigned height )
+{
+  static uint8_t image[ST7565_LCD_MAX_COLUMNS / 8 * ST7565_LCD_PARAM_HEIGHT];
+  static uint8_t pages[ST7565_LCD_MAX_ROWS][ST7565_LCD_MAX_COLUMNS];
+  unsigned x, y, stride = (width + 7) / 8, bad = 0;
+  int want, got;
+
+  CHECK(_test_pbm(sPath, width, height, image) == 0);
+  memset(pages, 0xA5, sizeof(pages));
+  CHECK(lcd_image_read(sPath, &pages[0][0], ST7565_LCD_MAX_ROWS) == 0);
+  for (y = 0; y < ST7565_LCD_PARAM_HEIGHT; y++)
+  {
+    for (x = 0; x < ST7565_LCD_MAX_COLUMNS; x++)
+    {
+      /* The first row of a page is its MSB */
+      want = (x < width && y < height) ? 
+        (image[y * stride + x / 8] >> (7 - x % 8)) & 1 : 0;
+      got = (pages[y / 8][x] >> (7 - y % 8)) & 1;
+      if (want != got) bad++;
+    }
+  }
+  CHECK(bad == 0);
+}
+
+int main ( void )
+{
+  char sDir[] = "/tmp/lcdST7565-test-XXXXXX";
+  char sPath[128];
+
+  if (mkdtemp(sDir) == NULL) return 1;
+  snprintf(sPath, sizeof(sPath), "%s/image.pbm", sDir);
+  /* The whole screen - all pages go through the wide kernel */
+  _test_image(sPath, ST7565_LCD_MAX_COLUMNS, ST7565_LCD_PARAM_HEIGHT);
+  /* Partial pages and a part of a byte at the right edge */
+  _test_image(sPath, 100, 45);
+  unlink(sPath);
+  rmdir(sDir);
+
+#ifdef ST7565_LCD_IMAGE_SSE2
+  printf("%s image sse2\n", gs_failed ? "FAIL" : "ok");
+#else
+  printf("%s image\n", gs_failed ? "FAIL" : "ok");
+#endif
+  return gs_failed;
+}
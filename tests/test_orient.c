@@ -0,0 +1,67 @@
+/************************************************************************/
+/* Test of the 180 degree Orientation on the Simulated LCD              */
+/************************************************************************/
+
+/*
+  Built with 'make test'. Turned by 180 degrees the controller reads the
+  RAM from the other end, so the columns of the generic panel move to
+  RAM columns 4 - 131. The right edge is flushed and looked for in the
+  RAM - past column 127 it needs the full upper nibble of the address.
+*/
+
+#define main lcd_main
+#include "../lcdST7565.c"
+#undef main
+
+static int gs_failed;
+
+#define CHECK(c) do { if (!(c)) { printf("FAIL %s:%d %s\n", __FILE__, \
+  __LINE__, #c); gs_failed = 1; } } while (0)
+
+int main ( void )
+{
+  /* Where the generic panel is shown with the ADC reversed */
+  const unsigned offset = ST7565_LCD_RAM_COLUMNS - ST7565_LCD_MAX_COLUMNS;
+  uint8_t data[8];
+  unsigned page, c;
+
+  setenv("LCD_STATE", "", 1);
+  setenv("LCD_PANEL", "generic", 1);
+  CHECK(gp_lcd->io->init() == 0);
+  CHECK(init_io() == 0);
+  CHECK(lcd_init() == 0);
+  CHECK(lcd_clear() == 0);
+  page = _lcd_page(0);
+
+  CHECK(lcd_orient(180, 0) == 0);
+  CHECK(gp_lcd->sim.adc_reverse == 1);
+  CHECK(gp_lcd->sim.com_reverse == 1);
+
+  /* A flush of the last 8 columns */
+  for (c = 0; c < sizeof(data); c++) data[c] = (uint8_t)(0x11 * (c + 1));
+  CHECK(lcd_fb_write(ST7565_LCD_MAX_COLUMNS - 8, 0, data, sizeof(data)) == 0);
+  CHECK(lcd_flush() == 0);
+  CHECK(memcmp(&gp_lcd->sim.ram[page][ST7565_LCD_MAX_COLUMNS - 8 + offset],
+    data, sizeof(data)) == 0);
+  /* ... and the last 2 again - addressed at RAM column 130 */
+  data[6] = 0x5A;
+  data[7] = 0xA5;
+  CHECK(lcd_fb_write(ST7565_LCD_MAX_COLUMNS - 2, 0, &data[6], 2) == 0);
+  CHECK(lcd_flush() == 0);
+  CHECK(memcmp(&gp_lcd->sim.ram[page][ST7565_LCD_MAX_COLUMNS - 8 + offset],
+    data, sizeof(data)) == 0);
+  /* Nothing on the RAM columns that are not shown */
+  for (c = 0; c < offset; c++) CHECK(gp_lcd->sim.ram[page][c] == 0);
+
+  /* Turned back, the screen goes back to RAM columns 0 - 127 */
+  CHECK(lcd_orient(0, 0) == 0);
+  CHECK(gp_lcd->sim.adc_reverse == 0);
+  CHECK(memcmp(&gp_lcd->sim.ram[page][ST7565_LCD_MAX_COLUMNS - 8],
+    data, sizeof(data)) == 0);
+
+  close_io();
+  gp_lcd->io->term();
+
+  printf("%s orient\n", gs_failed ? "FAIL" : "ok");
+  return gs_failed;
+}
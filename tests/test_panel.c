@@ -0,0 +1,85 @@
+/************************************************************************/
+/* Test of the Panel Profiles on the Simulated LCD                      */
+/************************************************************************/
+
+/*
+  Built with 'make test'. Each profile is taken and the right edge of
+  the first row is written, directly and through the Shadow. The data
+  has to land in the RAM columns of the profile offset - a right edge
+  past RAM column 127 needs the full upper nibble of the column address.
+*/
+
+#define main lcd_main
+#include "../lcdST7565.c"
+#undef main
+
+static int gs_failed;
+
+#define CHECK(c) do { if (!(c)) { printf("FAIL %s:%d %s\n", __FILE__, \
+  __LINE__, #c); gs_failed = 1; } } while (0)
+
+/**
+ *  Function to write the right edge of row 0 and check where it went
+ */
+static void _test_edge ( const char *sName, unsigned offset )
+{
+  static const uint8_t edge[4] = { 0xAA, 0xBB, 0xCC, 0xDD };
+  uint8_t data[8];
+  unsigned page, c;
+
+  CHECK(lcd_panel(sName) == 0);
+  CHECK(lcd_init() == 0);
+  /* The warm start sends the Shadow of the last profile again - on the
+     Adafruit panel the extra row is shown through the page of row 0 */
+  CHECK(lcd_clear() == 0);
+  page = _lcd_page(0);
+
+  /* Addressing the last column */
+  CHECK(lcd_goto(ST7565_LCD_MAX_COLUMNS - 1, 0) == 0);
+  CHECK(gp_lcd->sim.column == ST7565_LCD_MAX_COLUMNS - 1 + offset);
+  CHECK(gp_lcd->hw_column == gp_lcd->sim.column);
+
+  /* Data written at the cursor */
+  CHECK(lcd_goto(ST7565_LCD_MAX_COLUMNS - 4, 0) == 0);
+  CHECK(lcd_data_buf(edge, sizeof(edge)) == 0);
+  CHECK(memcmp(&gp_lcd->sim.ram[page][ST7565_LCD_MAX_COLUMNS - 4 + offset],
+    edge, sizeof(edge)) == 0);
+
+  /* A flush of the last 8 columns */
+  for (c = 0; c < sizeof(data); c++) data[c] = (uint8_t)(0x11 * (c + 1));
+  CHECK(lcd_fb_write(ST7565_LCD_MAX_COLUMNS - 8, 0, data, sizeof(data)) == 0);
+  CHECK(lcd_flush() == 0);
+  CHECK(memcmp(&gp_lcd->sim.ram[page][ST7565_LCD_MAX_COLUMNS - 8 + offset],
+    data, sizeof(data)) == 0);
+  /* ... and nothing on the other side of the RAM */
+  for (c = 0; c < offset; c++) CHECK(gp_lcd->sim.ram[page][c] == 0);
+}
+
+int main ( void )
+{
+  char sDir[] = "/tmp/lcdST7565-test-XXXXXX";
+  char sPath[128];
+  FILE *f;
+
+  setenv("LCD_STATE", "", 1);
+  if (mkdtemp(sDir) == NULL) return 1;
+  snprintf(sPath, sizeof(sPath), "%s/lcdST7565.conf", sDir);
+  f = fopen(sPath, "w");
+  if (f == NULL) return 1;
+  fprintf(f, "[offset4]\noffset = 4\n");
+  fclose(f);
+  setenv("LCD_PANELS", sPath, 1);
+
+  CHECK(gp_lcd->io->init() == 0);
+  CHECK(init_io() == 0);
+  _test_edge("generic", 0);
+  _test_edge("adafruit", 1);
+  _test_edge("offset4", 4);
+  close_io();
+  gp_lcd->io->term();
+
+  unlink(sPath);
+  rmdir(sDir);
+  printf("%s panel\n", gs_failed ? "FAIL" : "ok");
+  return gs_failed;
+}
@@ -0,0 +1,76 @@
+/************************************************************************/
+/* Test of the Update Planner on the Simulated LCD                      */
+/************************************************************************/
+
+/*
+  Built with 'make test'. Two sparse changes of a frame are sent with
+  lcd_frame: runs a few columns apart go in one segment with the columns
+  between them, runs far apart are addressed each. The bus times are set
+  so the outcome does not depend on the SPI clock of the build.
+*/
+
+#define main lcd_main
+#include "../lcdST7565.c"
+#undef main
+
+static int gs_failed;
+
+#define CHECK(c) do { if (!(c)) { printf("FAIL %s:%d %s\n", __FILE__, \
+  __LINE__, #c); gs_failed = 1; } } while (0)
+
+/* Text row the changes are made in */
+#define TEST_ROW                             2
+
+/**
+ *  Function to send two runs of 4 changed columns in TEST_ROW and check
+ *  the segments, the data sent and the RAM
+ */
+static void _test_runs ( unsigned first, unsigned second, unsigned segments,
+  unsigned long bytes )
+{
+  static uint8_t frame[ST7565_LCD_MAX_ROWS][ST7565_LCD_MAX_COLUMNS];
+  const uint8_t *pRam = &gp_lcd->sim.ram[_lcd_page(TEST_ROW)][0];
+  unsigned long seg = gp_lcd->stats.plan_segments;
+  unsigned long data = gp_lcd->stats.data_bytes;
+  unsigned c;
+
+  memcpy(frame, gp_lcd->fb.data, sizeof(frame));
+  for (c = 0; c < 4; c++)
+  {
+    frame[TEST_ROW][first + c] ^= (uint8_t)(0x11 * (c + 1));
+    frame[TEST_ROW][second + c] ^= (uint8_t)(0x11 * (c + 5));
+  }
+  CHECK(lcd_frame(&frame[0][0]) == 0);
+  CHECK(gp_lcd->stats.plan_segments - seg == segments);
+  CHECK(gp_lcd->stats.data_bytes - data == bytes);
+  CHECK(memcmp(gp_lcd->fb.data, frame, sizeof(frame)) == 0);
+  CHECK(memcmp(pRam, frame[TEST_ROW], ST7565_LCD_MAX_COLUMNS) == 0);
+}
+
+int main ( void )
+{
+  setenv("LCD_STATE", "", 1);
+  setenv("LCD_PANEL", "generic", 1);
+  CHECK(gp_lcd->io->init() == 0);
+  CHECK(init_io() == 0);
+  CHECK(lcd_init() == 0);
+  CHECK(lcd_clear() == 0);
+  CHECK(lcd_flush() == 0);
+
+  /* A byte is 1 us, a new segment with its addressing over 40 us */
+  gp_lcd->cost.cmd_byte = 1000;
+  gp_lcd->cost.data_byte = 1000;
+  gp_lcd->cost.a0 = 1000;
+  gp_lcd->cost.transfer = 20000;
+
+  /* 2 columns apart - merged, the gap is sent along */
+  _test_runs(10, 16, 1, 10);
+  /* 100 columns apart - each run addressed */
+  _test_runs(4, 108, 2, 8);
+
+  close_io();
+  gp_lcd->io->term();
+
+  printf("%s plan\n", gs_failed ? "FAIL" : "ok");
+  return gs_failed;
+}
@@ -0,0 +1,212 @@
+/************************************************************************/
+/* Test of the spidev Transport against a fake spidev                  */
+/************************************************************************/
+
+/*
+  Built with 'make test'. The driver is included with its ioctl calls
+  going to a fake: the GPIO line requests and values are recorded, and
+  each SPI_IOC_MESSAGE is checked for the transfer limits and recorded
+  with the level of A0. The device paths point to files of a temporary
+  directory, so no hardware or device node is needed.
+*/
+
+#include <errno.h>
+#include <stdarg.h>
+#include <sys/ioctl.h>
+
+/* The device paths of the fake */
+static char gs_fake_spidev[64];
+static char gs_fake_gpiochip[64];
+#define ST7565_LCD_SPIDEV_PATH               gs_fake_spidev
+#define ST7565_LCD_GPIOCHIP_PATH             gs_fake_gpiochip
+
+int _fake_ioctl ( int fd, unsigned long request, ... );
+#define ioctl _fake_ioctl
+#define main lcd_main
+#include "../lcdST7565.c"
+#undef main
+#undef ioctl
+
+/* Lines requested - GPIO number, fd handed out and level */
+#define FAKE_LINES                           4
+static struct
+{
+  unsigned gpio;
+  int      fd;
+  unsigned level;
+} gs_lines[FAKE_LINES];
+static unsigned gs_line_count;
+/* Level changes of nRST, bit 0 first */
+static unsigned long gs_nrst_log;
+static unsigned gs_nrst_changes;
+
+/* SPI bytes written, as sent with A0 low and high */
+static uint8_t gs_spi[2][65536];
+static size_t gs_spi_len[2];
+static unsigned long gs_messages, gs_transfers;
+/* 1 - Fail the SPI messages */
+static int gs_spi_error;
+static int gs_failed;
+
+#define CHECK(c) do { if (!(c)) { printf("FAIL %s:%d %s\n", __FILE__, \
+  __LINE__, #c); gs_failed = 1; } } while (0)
+
+static unsigned *_fake_level ( unsigned gpio )
+{
+  unsigned i;
+  for (i = 0; i < gs_line_count; i++)
+  {
+    if (gs_lines[i].gpio == gpio) return &gs_lines[i].level;
+  }
+  return NULL;
+}
+
+int _fake_ioctl ( int fd, unsigned long request, ... )
+{
+  void *pArg;
+  va_list ap;
+  unsigned i;
+
+  va_start(ap, request);
+  pArg = va_arg(ap, void *);
+  va_end(ap);
+
+  if (request == GPIO_V2_GET_LINE_IOCTL)
+  {
+    struct gpio_v2_line_request *pReq = pArg;
+    if (gs_line_count >= FAKE_LINES || pReq->num_lines != 1) return -1;
+    CHECK(pReq->config.flags & GPIO_V2_LINE_FLAG_OUTPUT);
+    gs_lines[gs_line_count].gpio = pReq->offsets[0];
+    gs_lines[gs_line_count].level = (pReq->config.num_attrs > 0) ?
+      (unsigned)(pReq->config.attrs[0].attr.values & 1) : 0;
+    pReq->fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+    gs_lines[gs_line_count++].fd = pReq->fd;
+    return 0;
+  }
+  if (request == GPIO_V2_LINE_SET_VALUES_IOCTL)
+  {
+    struct gpio_v2_line_values *pVal = pArg;
+    for (i = 0; i < gs_line_count; i++)
+    {
+      if (gs_lines[i].fd != fd) continue;
+      if (gs_lines[i].gpio == gs_lcd[0].nrst_pin &&
+        gs_lines[i].level != (pVal->bits & 1) && gs_nrst_changes < 32)
+      {
+        gs_nrst_log |= (unsigned long)(pVal->bits & 1) << gs_nrst_changes++;
+      }
+      gs_lines[i].level = (unsigned)(pVal->bits & 1);
+      return 0;
+    }
+    return -1;
+  }
+  if (request == SPI_IOC_WR_MODE || request == SPI_IOC_WR_BITS_PER_WORD ||
+    request == SPI_IOC_WR_MAX_SPEED_HZ)
+  {
+    return 0;
+  }
+  if (_IOC_TYPE(request) == SPI_IOC_MAGIC && _IOC_NR(request) == 0)
+  {
+    const struct spi_ioc_transfer *pXfer = pArg;
+    unsigned n = _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer);
+    unsigned *pA0 = _fake_level(gs_lcd[0].a0_pin);
+    unsigned a0 = (pA0 != NULL) ? *pA0 : 0;
+    if (gs_spi_error)
+    {
+      errno = EIO;
+      return -1;
+    }
+    CHECK(n >= 1 && n <= ST7565_LCD_SPIDEV_MAXXFER);
+    ++gs_messages;
+    for (i = 0; i < n; i++)
+    {
+      CHECK(pXfer[i].len >= 1 && pXfer[i].len <= ST7565_LCD_SPIDEV_XFER);
+      CHECK(pXfer[i].rx_buf == 0);
+      if (gs_spi_len[a0] + pXfer[i].len <= sizeof(gs_spi[a0]))
+      {
+        memcpy(&gs_spi[a0][gs_spi_len[a0]],
+          (const void *)(uintptr_t)pXfer[i].tx_buf, pXfer[i].len);
+      }
+      gs_spi_len[a0] += pXfer[i].len;
+      ++gs_transfers;
+    }
+    return (int)n;
+  }
+  return ioctl(fd, request, pArg);
+}
+
+int main ( void )
+{
+  static uint8_t big[40000];
+  char sDir[] = "/tmp/lcdST7565-test-XXXXXX";
+  unsigned *pLevel;
+  size_t i;
+  int fd;
+
+  /* The device nodes are plain files */
+  if (mkdtemp(sDir) == NULL) return 1;
+  snprintf(gs_fake_gpiochip, sizeof(gs_fake_gpiochip), "%s/gpiochip0",
+    sDir);
+  fd = open(gs_fake_gpiochip, O_CREAT | O_WRONLY, 0644);
+  close(fd);
+  snprintf(gs_fake_spidev, sizeof(gs_fake_spidev), "%s/spidev0.0", sDir);
+  fd = open(gs_fake_spidev, O_CREAT | O_WRONLY, 0644);
+  close(fd);
+  snprintf(gs_fake_spidev, sizeof(gs_fake_spidev), "%s/spidev0.%%u", sDir);
+  setenv("LCD_STATE", "", 1);
+
+  /* Open - A0 low, nRST requested high so the LCD is not reset */
+  CHECK(gp_lcd->io == &gs_io_spidev && gp_lcd->io->init() == 0);
+  CHECK(init_io() == 0);
+  CHECK(gs_line_count == 2);
+  pLevel = _fake_level(gs_lcd[0].a0_pin);
+  CHECK(pLevel != NULL && *pLevel == 0);
+  pLevel = _fake_level(gs_lcd[0].nrst_pin);
+  CHECK(pLevel != NULL && *pLevel == 1);
+
+  /* Cold start - one Reset pulse, commands with A0 low and the
+     cleared screen as data with A0 high */
+  CHECK(lcd_init() == 0);
+  CHECK(gs_nrst_changes == 2 && gs_nrst_log == 2); /* Low, then high */
+  CHECK(gs_spi_len[0] > 0);
+  CHECK(gs_spi[0][0] == ST7565_LCD_CMD_SET_BIAS_7);
+  CHECK(gs_spi_len[1] == (size_t)ST7565_LCD_MAX_ROWS *
+    ST7565_LCD_MAX_COLUMNS);
+
+  /* Data bytes go out with A0 high */
+  gs_spi_len[0] = gs_spi_len[1] = 0;
+  CHECK(lcd_goto(5, 2) == 0);
+  CHECK(lcd_data(0x5A) == 0);
+  CHECK(gs_spi_len[1] == 1 && gs_spi[1][0] == 0x5A);
+  CHECK(gs_spi_len[0] > 0);
+
+  /* A failed addressing is reported and not taken as done */
+  gs_spi_error = 1;
+  CHECK(lcd_goto(9, 3) == -43);
+  gs_spi_error = 0;
+  gs_spi_len[0] = 0;
+  CHECK(lcd_goto(9, 3) == 0);
+  CHECK(gs_spi_len[0] > 0);
+
+  /* A long write is split into transfers of the spidev buffer size,
+     no more of them in one message than allowed */
+  for (i = 0; i < sizeof(big); i++) big[i] = (uint8_t)(i * 7 + (i >> 8));
+  CHECK(_lcd_a0(1) == 0);
+  gs_spi_len[1] = 0;
+  gs_messages = gs_transfers = 0;
+  CHECK(gp_lcd->io->write(big, sizeof(big)) == 0);
+  CHECK(gs_transfers == (sizeof(big) + ST7565_LCD_SPIDEV_XFER - 1) /
+    ST7565_LCD_SPIDEV_XFER);
+  CHECK(gs_messages == (gs_transfers + ST7565_LCD_SPIDEV_MAXXFER - 1) /
+    ST7565_LCD_SPIDEV_MAXXFER);
+  CHECK(gs_spi_len[1] == sizeof(big) &&
+    memcmp(gs_spi[1], big, sizeof(big)) == 0);
+
+  close_io();
+  gp_lcd->io->term();
+  snprintf(gs_fake_spidev, sizeof(gs_fake_spidev), "%s/spidev0.0", sDir);
+  unlink(gs_fake_spidev);
+  unlink(gs_fake_gpiochip);
+  rmdir(sDir);
+  printf("%s spidev\n", gs_failed ? "FAIL" : "ok");
+  return gs_failed;
+}